@@ -0,0 +1,900 @@
+#include <vector>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <memory>
+#include <iomanip>
+#include <thread>
+#include <cmath>
+
+#include "./Tools/WaveEquationSolver.cpp" // Include the WaveEquationSolver implementation
+#include "./Tools/CSVReader.cpp"
+#include "./Tools/Norms.cpp"
+#include "./Tools/Batch.cpp"
+#include "./Tools/AsyncSink.cpp"
+#include "./Tools/ResultFile.cpp"
+#include "./Tools/Compression.cpp"
+#include "./Tools/Pyramid.cpp"
+#include "./Tools/Refinement.cpp"
+
+/// @brief Runs a case several times and returns the best wall time
+/// @param repetitions Number of runs
+/// @param run The case to time
+/// @return Best wall time in seconds
+double bestOf(int repetitions, const std::function<void()>& run) {
+    double best = 1e300;
+    for (int r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/// @class DiscardSink
+/// @brief Sink that keeps nothing, so solve timings are the stepping alone
+class DiscardSink : public RowSink {
+public:
+    void write(int level, double t, const double* row, int n) override {}
+};
+
+/// @brief Size of a file in bytes
+long long fileSize(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    return in.is_open() ? static_cast<long long>(in.tellg()) : 0;
+}
+
+/// @brief The original writeMatixToCSV loop: one `operator<<` per value
+void writeLegacyCSV(const std::string& filename, const std::vector<std::vector<double>>& matrix, double x_min, double dx, double dt) {
+    std::ofstream out(filename);
+    out << "x, t, f\n";
+    for (size_t i = 0; i < matrix.size(); i++) {
+        for (size_t j = 0; j < matrix[i].size(); j++) {
+            double x = x_min + j * dx;
+            out << x << ", " << i * dt << ", " << matrix[i][j] << "\n";
+        }
+    }
+}
+
+/// @brief CSV output throughput: iostream writer against CSVWriter
+void benchCSVWriters() {
+    Bondary SET2_EXP = {SET2_Function, 0, 0};
+    Input input = {1.75, 100.0, -50.0, 50.0, 10, 2000, 0.5, SET2_EXP};
+    WaveEquationSolver solver(input);
+    solver.solve(WaveEquationSolver::Lax_Wendroff, [&](int level, double t, const double* row, int n) {
+        solver.matrix.emplace_back(row, row + n);
+    });
+    const std::string filename = "bench_output.csv";
+
+    std::cout << "CSV writers (N=" << input.N << ", " << solver.matrix.size() << " levels)\n";
+    double legacy = bestOf(3, [&]() {
+        writeLegacyCSV(filename, solver.matrix, input.x_min, solver.dx, solver.dt);
+    });
+    double bytes = static_cast<double>(fileSize(filename));
+    std::printf("  %-28s %8.3f s %10.1f MB/s\n", "iostream (legacy)", legacy, bytes / legacy / 1e6);
+
+    for (int precision : {6, 17, CSVWriter::SHORTEST}) {
+        double fast = bestOf(3, [&]() {
+            solver.writeMatixToCSV(filename, precision);
+        });
+        bytes = static_cast<double>(fileSize(filename));
+        std::string name = "CSVWriter precision " + (precision == CSVWriter::SHORTEST ? std::string("shortest") : std::to_string(precision));
+        std::printf("  %-28s %8.3f s %10.1f MB/s\n", name.c_str(), fast, bytes / fast / 1e6);
+    }
+    std::remove(filename.c_str());
+}
+
+/// @brief The original readFColumn loop: getline, istringstream and stold per row
+std::vector<long double> readLegacyFColumn(const std::string& filePath) {
+    std::ifstream file(filePath);
+    std::vector<long double> f_values;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        std::string x, t, f;
+        std::getline(ss, x, ',');
+        std::getline(ss, t, ',');
+        std::getline(ss, f, ',');
+        f_values.push_back(std::stold(f));
+    }
+    return f_values;
+}
+
+/// @brief CSV ingestion throughput: getline/stold against the mapped from_chars reader
+void benchCSVReader() {
+    Bondary SET2_EXP = {SET2_Function, 0, 0};
+    Input input = {1.75, 100.0, -50.0, 50.0, 10, 2000, 0.5, SET2_EXP};
+    WaveEquationSolver solver(input);
+    const std::string filename = "bench_output.csv";
+    CSVSink csv(filename, CSVWriter::SHORTEST);
+    solver.solve(WaveEquationSolver::Lax_Wendroff, csv);
+    double bytes = static_cast<double>(fileSize(filename));
+
+    std::cout << "CSV readers (" << bytes / 1e6 << " MB)\n";
+    size_t count = 0;
+    double legacy = bestOf(1, [&]() { count = readLegacyFColumn(filename).size(); });
+    std::printf("  %-28s %8.3f s %10.1f MB/s (%zu values)\n", "getline + stold (legacy)", legacy, bytes / legacy / 1e6, count);
+
+    for (unsigned threads : {1u, 0u}) {
+        double fast = bestOf(3, [&]() {
+            std::vector<long double> values;
+            CSVColumnReader reader(threads);
+            reader.read(filename, "f", values);
+            count = values.size();
+        });
+        std::string name = "CSVColumnReader " + (threads ? std::to_string(threads) + " thread" : std::string("all threads"));
+        std::printf("  %-28s %8.3f s %10.1f MB/s (%zu values)\n", name.c_str(), fast, bytes / fast / 1e6, count);
+    }
+    std::remove(filename.c_str());
+}
+
+/// @brief Roofline-style comparison of the level-by-level loop and temporal blocking
+/// @note Naive loop traffic is taken as 16 bytes per point update (one read, one
+///       write); blocking divides it by the number of levels per tile.
+void benchTemporalBlocking() {
+    const double flops[2] = {3, 9}; // Per point update: FTBS, Lax-Wendroff
+    const char* names[2] = {"E_FTBS", "LW"};
+    const SchemeCoefficients k = SchemeCoefficients::make(0.01, 0.005, 1.0);
+    std::cout << "Temporal blocking (points updated per second)\n";
+    std::printf("  %-7s %9s %6s %10s %9s %9s %9s\n", "scheme", "N", "levels", "Mpts/s", "GFLOP/s", "GB/s", "flop/B");
+
+    for (int N : {10000, 1000000, 4000000}) {
+        const int steps = std::max(16, static_cast<int>(2e8 / N) / 16 * 16);
+        for (int s = 0; s < 2; s++) {
+            int left = 1, right = (s == 0) ? 0 : 1;
+            auto kernel = (s == 0) ? Row_Schemes::FTBS : Row_Schemes::Lax_Wendroff;
+            for (int levels : {1, 4, 16}) {
+                std::vector<double> a(N), b(N);
+                // Offset keeps the tails away from subnormal values
+                for (int i = 0; i < N; i++) a[i] = b[i] = 1.0 + SET2_Function(-50.0 + i * 100.0 / N);
+                TemporalBlocker blocker(2048);
+                double seconds = bestOf(2, [&]() {
+                    double* current = a.data();
+                    double* spare = b.data();
+                    for (int done = 0; done < steps; done += levels) {
+                        if (levels == 1) {
+                            kernel(k, current, spare, left, N - right);
+                        } else {
+                            blocker.advance(kernel, left, right, k, current, spare, N, left, N - right, levels);
+                        }
+                        std::swap(current, spare);
+                    }
+                });
+                double points = static_cast<double>(N) * steps;
+                std::printf("  %-7s %9d %6d %10.1f %9.2f %9.2f %9.2f\n", names[s], N, levels, points / seconds / 1e6,
+                            points * flops[s] / seconds / 1e9, points * 16 / levels / seconds / 1e9, flops[s] * levels / 16);
+            }
+        }
+    }
+}
+
+/// @brief Distance in units in the last place between two finite values
+template <class T>
+long long ulpDistance(T a, T b) {
+    typedef typename std::conditional<sizeof(T) == 8, int64_t, int32_t>::type Bits;
+    Bits ia, ib;
+    std::memcpy(&ia, &a, sizeof(T));
+    std::memcpy(&ib, &b, sizeof(T));
+    // Map the sign-magnitude encoding onto a monotonic integer line
+    if (ia < 0) ia = std::numeric_limits<Bits>::min() - ia;
+    if (ib < 0) ib = std::numeric_limits<Bits>::min() - ib;
+    return std::llabs(static_cast<long long>(ia) - static_cast<long long>(ib));
+}
+
+/// @brief Throughput of the SIMD kernels per instruction set and precision
+/// @note Agreement is checked against the scalar kernels of the same precision
+///       after all the timed steps; the tolerance is SIMD_ULP_TOLERANCE.
+template <class T>
+void benchSimdPrecision(const char* precision) {
+    const double flops[4] = {3, 4, 8, 8}; // Per point update: FTBS, I_FTBS, Lax-Wendroff, Richtmyer
+    const char* names[4] = {"E_FTBS", "I_FTBS", "LW", "Richtmyer"};
+    const SimdStencil stencils[4] = {SimdStencil::FTBS, SimdStencil::Implicit_FTBS, SimdStencil::Lax_Wendroff, SimdStencil::Richtmyer};
+    const SimdCoefficients<T> k = SimdCoefficients<T>::make(SchemeCoefficients::make(0.01, 0.005, 1.0));
+
+    for (int N : {10000, 1000000}) {
+        const int steps = std::max(10, static_cast<int>(2e8 / N));
+        for (int s = 0; s < 4; s++) {
+            std::vector<T> reference;
+            for (SimdISA isa : {SimdISA::Scalar, SimdISA::SSE2, SimdISA::AVX2, SimdISA::AVX512}) {
+                if (!simdSupported(isa)) continue;
+                SimdRow<T> a(N), b(N), half(N);
+                T* current = nullptr;
+                double seconds = bestOf(2, [&]() {
+                    // Offset keeps the tails away from subnormal values
+                    for (int i = 0; i < N; i++) a[i] = b[i] = half[i] = static_cast<T>(1.0 + SET2_Function(-50.0 + i * 100.0 / N));
+                    SimdStepper<T> stepper(SimdKernelSet<T>::select(isa), k, 2, N - 2);
+                    current = a.data();
+                    T* spare = b.data();
+                    for (int step = 0; step < steps; step++) {
+                        stepper.step(stencils[s], current, spare, half.data());
+                    }
+                });
+                long long ulp = 0;
+                if (isa == SimdISA::Scalar) {
+                    reference.assign(current, current + N);
+                } else {
+                    for (int i = 0; i < N; i++) ulp = std::max(ulp, ulpDistance(current[i], reference[i]));
+                }
+                double points = static_cast<double>(N) * steps;
+                std::printf("  %-7s %-9s %-7s %9d %10.1f %9.2f %8lld %s\n", precision, names[s], simdName(isa), N,
+                            points / seconds / 1e6, points * flops[s] / seconds / 1e9, ulp, ulp <= SIMD_ULP_TOLERANCE ? "ok" : "FAIL");
+            }
+        }
+    }
+}
+
+/// @brief Agreement of every SIMD kernel set with Row_Schemes, one step at a time
+/// @note Each step of a kernel is compared with the Row_Schemes step (in double, rounded
+///       to T) from the same row, over small and odd N where the vector blocks overrun
+///       both ends of the update range; the points outside the range must not change.
+/// @return Number of scheme, ISA and N combinations beyond SIMD_ULP_TOLERANCE
+template <class T>
+int checkSimdPrecision(const char* precision) {
+    const char* names[4] = {"E_FTBS", "I_FTBS", "LW", "Richtmyer"};
+    const SimdStencil stencils[4] = {SimdStencil::FTBS, SimdStencil::Implicit_FTBS, SimdStencil::Lax_Wendroff, SimdStencil::Richtmyer};
+    const SchemeCoefficients k = SchemeCoefficients::make(0.01, 0.005, 1.0);
+    const int steps = 20;
+    int failures = 0;
+
+    for (int s = 0; s < 4; s++) {
+        for (SimdISA isa : {SimdISA::Scalar, SimdISA::SSE2, SimdISA::AVX2, SimdISA::AVX512}) {
+            if (!simdSupported(isa)) continue;
+            long long worst = 0;
+            bool outside = false; // A point outside the update range changed
+            for (int N : {5, 6, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 127, 1001}) {
+                // The update ranges of the solver (WaveEquationSolver::updateRange)
+                const int begin = (s == 0 || s == 3) ? 1 : 2;
+                const int end = (s == 0) ? N : (s == 1) ? N - 1 : N - 2;
+                SimdRow<T> a(N), b(N), half(N);
+                for (int i = 0; i < N; i++) a[i] = b[i] = half[i] = static_cast<T>(1.0 + SET2_Function(-50.0 + i * 100.0 / N));
+                SimdStepper<T> stepper(SimdKernelSet<T>::select(isa), SimdCoefficients<T>::make(k), begin, end);
+                T* current = a.data();
+                T* spare = b.data();
+                std::vector<double> prev(N), next(N), predicted(N);
+                for (int step = 0; step < steps; step++) {
+                    for (int i = 0; i < N; i++) prev[i] = next[i] = predicted[i] = current[i];
+                    switch (s) {
+                    case 0: Row_Schemes::FTBS(k, prev.data(), next.data(), begin, end); break;
+                    case 1: Row_Schemes::I_FTBS(k, prev.data(), next.data(), begin, end); break;
+                    case 2: Row_Schemes::Lax_Wendroff(k, prev.data(), next.data(), begin, end); break;
+                    case 3:
+                        Row_Schemes::Richtmyer_prediction(k, prev.data(), predicted.data(), begin, end);
+                        Row_Schemes::Richtmyer_correction(k, prev.data(), predicted.data(), next.data(), begin, end);
+                        break;
+                    }
+                    for (int i = 0; i < N; i++) half[i] = current[i];
+                    stepper.step(stencils[s], current, spare, half.data());
+                    for (int i = 0; i < N; i++) {
+                        const T expected = static_cast<T>(next[i]);
+                        if (i >= begin && i < end) worst = std::max(worst, ulpDistance(current[i], expected));
+                        else outside = outside || current[i] != expected;
+                    }
+                }
+            }
+            const bool ok = worst <= SIMD_ULP_TOLERANCE && !outside;
+            if (!ok) failures++;
+            std::printf("  %-7s %-9s %-7s %8lld %s\n", precision, names[s], simdName(isa), worst,
+                        ok ? "ok" : outside ? "FAIL (changed a point outside the update range)" : "FAIL");
+        }
+    }
+    return failures;
+}
+
+/// @brief SIMD kernel agreement and throughput for double and float rows
+/// @return False when a kernel disagrees with Row_Schemes beyond SIMD_ULP_TOLERANCE
+bool benchSimd() {
+    std::cout << "SIMD kernels against Row_Schemes (max ULP per step, N = 5 .. 1001, tolerance " << SIMD_ULP_TOLERANCE << ")\n";
+    int failures = checkSimdPrecision<double>("double") + checkSimdPrecision<float>("float");
+    std::cout << "SIMD kernels (best ISA on this CPU: " << simdName(simdBest()) << ")\n";
+    std::printf("  %-7s %-9s %-7s %9s %10s %9s %8s\n", "type", "scheme", "ISA", "N", "Mpts/s", "GFLOP/s", "max ULP");
+    benchSimdPrecision<double>("double");
+    benchSimdPrecision<float>("float");
+    return failures == 0;
+}
+
+/// @brief Norm reduction throughput: four long double passes against the fused engine
+/// @note The long double results of the legacy passes are the accuracy reference.
+void benchNorms() {
+    const size_t n = 10000000;
+    std::vector<long double> legacyValues(n);
+    std::vector<double> values(n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = SET2_Function(-5.0 + 10.0 * i / n) - 0.25;
+        legacyValues[i] = values[i];
+    }
+    const double bytes = static_cast<double>(n * sizeof(double));
+
+    std::cout << "Norms L1, L2, LInf, Lp(2.5) (" << n << " values)\n";
+    long double ref[4];
+    double legacy = bestOf(2, [&]() {
+        ref[0] = Norms::L1(legacyValues);
+        ref[1] = Norms::L2(legacyValues);
+        ref[2] = Norms::LInf(legacyValues);
+        ref[3] = Norms::Lp(legacyValues, 2.5);
+    });
+    std::printf("  %-28s %8.3f s %10.1f Mval/s\n", "Norms (4 long double passes)", legacy, n / legacy / 1e6);
+
+    for (double p : {2.5, 3.0, 2.7}) {
+        for (unsigned threads : {1u, 0u}) {
+            NormAccumulator norms;
+            double fused = bestOf(5, [&]() { norms = FusedNorms::compute(values, p, threads); });
+            char name[64];
+            std::snprintf(name, sizeof(name), "FusedNorms p=%.1f %s", p, threads ? "1 thread" : "all threads");
+            std::printf("  %-28s %8.3f s %10.1f Mval/s %7.1f GB/s %6.1fx", name, fused, n / fused / 1e6, bytes / fused / 1e9, legacy / fused);
+            if (p == 2.5) {
+                long double err = 0;
+                double got[4] = {norms.L1(), norms.L2(), norms.LInf(), norms.Lp()};
+                for (int k = 0; k < 4; k++) err = std::max(err, std::fabs((got[k] - ref[k]) / ref[k]));
+                std::printf("  max rel. diff %.2Le", err);
+            }
+            std::printf("\n");
+        }
+    }
+}
+
+/// @brief Cross-resolution resampling: Norms::interpolate per row against a reused ResamplePlan
+void benchResample() {
+    const int rows = 2000;
+    std::cout << "Resampling (" << rows << " rows)\n";
+    for (int n : {400, 4000}) {
+        const int m = n / 4 + 37; // Non-integer ratio
+        std::vector<double> values(static_cast<size_t>(rows) * n);
+        for (size_t i = 0; i < values.size(); i++) values[i] = SET2_Function(-5.0 + 10.0 * (i % n) / n);
+        std::vector<std::vector<long double>> legacyRows(rows, std::vector<long double>(n));
+        for (int r = 0; r < rows; r++) std::copy(values.begin() + static_cast<size_t>(r) * n, values.begin() + static_cast<size_t>(r + 1) * n, legacyRows[r].begin());
+
+        double points = static_cast<double>(rows) * m;
+        double legacy = bestOf(3, [&]() {
+            for (int r = 0; r < rows; r++) Norms::interpolate(legacyRows[r], m);
+        });
+        std::printf("  %5d -> %-5d %-26s %8.4f s %8.1f Mpts/s\n", n, m, "Norms::interpolate", legacy, points / legacy / 1e6);
+
+        std::vector<double> out(static_cast<size_t>(rows) * m);
+        for (auto method : {ResamplePlan::Method::Linear, ResamplePlan::Method::Cubic, ResamplePlan::Method::Average}) {
+            const char* name = (method == ResamplePlan::Method::Linear) ? "ResamplePlan linear" :
+                               (method == ResamplePlan::Method::Cubic) ? "ResamplePlan cubic" : "ResamplePlan average";
+            double seconds = bestOf(3, [&]() {
+                ResamplePlan plan = ResamplePlan::make(method, n, m);
+                plan.applyRows(values.data(), n, out.data(), m, rows);
+            });
+            std::printf("  %5d -> %-5d %-26s %8.4f s %8.1f Mpts/s %6.1fx\n", n, m, name, seconds, points / seconds / 1e6, legacy / seconds);
+        }
+    }
+}
+
+/// @brief Parameter scan throughput: one solve per configuration against interleaved batches
+/// @note Only the final level is recorded so the stepping dominates.
+void benchBatch() {
+    Bondary SET2_EXP = {SET2_Function, 0, 0};
+    const char* names[4] = {"E_FTBS", "I_FTBS", "LW", "Richtmyer"};
+    std::cout << "Batched configurations (u x CFL scan, final level only, 1 thread)\n";
+    std::printf("  %-9s %5s %7s %12s %12s %7s %s\n", "scheme", "N", "configs", "single cfg/s", "batch cfg/s", "gain", "check");
+    for (int N : {100, 400}) {
+        for (int s = 0; s < 4; s++) {
+            SweepSpace space;
+            space.N = {N};
+            space.bondaries = {SET2_EXP};
+            space.t_max = {10};
+            space.schemes = {static_cast<WaveEquationSolver::Scheme>(s)};
+            for (int i = 0; i < 16; i++) space.u.push_back(1.0 + 0.1 * i);
+            for (int i = 0; i < 16; i++) space.CFL.push_back(0.2 + 0.05 * i);
+            std::vector<SweepJob> jobs = space.jobs();
+            RecordPolicy policy;
+            policy.every = 0;
+            policy.last = true;
+
+            std::vector<std::vector<double>> single(jobs.size()), batched(jobs.size());
+            double serial = bestOf(3, [&]() {
+                for (size_t i = 0; i < jobs.size(); i++) {
+                    WaveEquationSolver solver(jobs[i].input);
+                    solver.solve(jobs[i].scheme, [&](int level, double t, const double* row, int n) { single[i].assign(row, row + n); }, policy);
+                }
+            });
+            std::vector<std::unique_ptr<CallbackSink>> own;
+            std::vector<RowSink*> sinks;
+            for (size_t i = 0; i < jobs.size(); i++) {
+                own.emplace_back(new CallbackSink([&batched, i](int level, double t, const double* row, int n) { batched[i].assign(row, row + n); }));
+                sinks.push_back(own.back().get());
+            }
+            double batch = bestOf(3, [&]() { BatchRunner(1).run(jobs, sinks, policy); });
+            bool same = (single == batched);
+            std::printf("  %-9s %5d %7zu %12.1f %12.1f %6.1fx %s\n", names[s], N, jobs.size(), jobs.size() / serial,
+                        jobs.size() / batch, serial / batch, same ? "identical" : "DIFFERENT");
+        }
+    }
+}
+
+/// @brief Tridiagonal solvers of the implicit schemes (Crank-Nicolson matrix at CFL 4)
+void benchBanded() {
+    const int n = 1000000;
+    const double off = 4.0 * 0.25;
+    std::vector<double> rhs(n), x(n);
+    for (int i = 0; i < n; i++) rhs[i] = SET2_Function(-5.0 + 10.0 * i / n);
+    std::cout << "Tridiagonal solvers (" << n << " unknowns)\n";
+
+    double factor = bestOf(3, [&]() { TridiagonalLU::constant(n, -off, 1.0, off); });
+    std::printf("  %-28s %8.4f s\n", "Thomas factorisation", factor);
+    TridiagonalLU thomas = TridiagonalLU::constant(n, -off, 1.0, off);
+    double seconds = bestOf(5, [&]() { x = rhs; thomas.solve(x.data()); });
+    std::printf("  %-28s %8.4f s %8.1f Mpts/s\n", "Thomas solve (cached LU)", seconds, n / seconds / 1e6);
+    PeriodicTridiagonalLU periodic = PeriodicTridiagonalLU::constant(n, -off, 1.0, off);
+    seconds = bestOf(5, [&]() { x = rhs; periodic.solve(x.data()); });
+    std::printf("  %-28s %8.4f s %8.1f Mpts/s\n", "Periodic (Sherman-Morrison)", seconds, n / seconds / 1e6);
+    for (int parts : {4, 16}) {
+        SpikeTridiagonal spike(n, -off, 1.0, off, parts);
+        seconds = bestOf(5, [&]() { x = rhs; spike.solve(x.data()); });
+        std::string name = "SPIKE " + std::to_string(parts) + " parts, 1 thread";
+        std::printf("  %-28s %8.4f s %8.1f Mpts/s\n", name.c_str(), seconds, n / seconds / 1e6);
+    }
+}
+
+/// @brief Output pipeline: compute alone, then binary and CSV files written inline against through an AsyncSink
+void benchAsyncOutput() {
+    Bondary set2 = {SET2_Function, 0, 0};
+    Input input = {1.75, 100, -50, 50, 2, 20000, 0.8, set2};
+    const std::string filename = "bench_output.wes";
+    std::cout << "Output pipeline (LW, N = " << input.N << ", " << WaveEquationSolver(input).stepCount(WaveEquationSolver::Lax_Wendroff)
+              << " levels written)\n";
+    double compute = bestOf(3, [&]() {
+        WaveEquationSolver solver(input);
+        DiscardSink discard;
+        solver.solve(WaveEquationSolver::Lax_Wendroff, discard);
+    });
+    std::printf("  %-28s %8.4f s\n", "compute only", compute);
+    for (const char* format : {"binary", "csv"}) {
+        auto output = [&](bool async) {
+            AsyncSinkMetrics metrics;
+            double seconds = bestOf(3, [&]() {
+                WaveEquationSolver solver(input);
+                std::unique_ptr<RowSink> file(std::strcmp(format, "csv") == 0 ? static_cast<RowSink*>(new CSVSink("bench_output.csv"))
+                                                                               : new BinarySink(filename));
+                if (async) {
+                    AsyncSink queue(*file, 16);
+                    solver.solve(WaveEquationSolver::Lax_Wendroff, queue);
+                    metrics = queue.metrics();
+                } else {
+                    solver.solve(WaveEquationSolver::Lax_Wendroff, *file);
+                }
+            });
+            std::string name = std::string(format) + (async ? ", AsyncSink" : ", inline");
+            std::printf("  %-28s %8.4f s", name.c_str(), seconds);
+            if (async) {
+                std::printf("  writer %.4f s, stalled %.4f s (%lld), depth max %d mean %.1f", metrics.writerSeconds, metrics.stallSeconds,
+                            metrics.stalls, metrics.maxDepth, metrics.meanDepth);
+            }
+            std::printf("\n");
+        };
+        output(false);
+        output(true);
+    }
+    std::remove(filename.c_str());
+    std::remove("bench_output.csv");
+}
+
+/// @brief Checkpoint overhead per interval, and an interrupted run resumed from its checkpoint against an uninterrupted one
+void benchCheckpoint() {
+    Bondary set2 = {SET2_Function, 0, 0};
+    Input input = {1.75, 100, -50, 50, 1, 100000, 0.8, set2};
+    RecordPolicy policy;
+    policy.every = 0;
+    policy.last = true;
+    const int steps = WaveEquationSolver(input).stepCount(WaveEquationSolver::Lax_Wendroff);
+    std::cout << "Checkpoint overhead (LW, N = " << input.N << ", " << steps << " steps)\n";
+    std::vector<double> reference;
+    for (int every : {0, 500, 100, 20}) {
+        double seconds = bestOf(3, [&]() {
+            WaveEquationSolver solver(input);
+            if (every > 0) solver.setCheckpoint("bench_checkpoint.wck", every, false);
+            solver.solve(WaveEquationSolver::Lax_Wendroff, [&](int, double, const double* row, int n) { reference.assign(row, row + n); },
+                         policy);
+        });
+        std::string name = (every > 0) ? "every " + std::to_string(every) + " levels" : "no checkpoint";
+        std::printf("  %-28s %8.4f s\n", name.c_str(), seconds);
+    }
+
+    // Interrupt a run halfway (an exception out of the sink), then resume it
+    struct Interrupted {};
+    std::remove("bench_checkpoint.wck");
+    RecordPolicy watch;
+    watch.every = 1;
+    try {
+        WaveEquationSolver solver(input);
+        solver.setCheckpoint("bench_checkpoint.wck", 100);
+        solver.solve(WaveEquationSolver::Lax_Wendroff, [&](int level, double, const double*, int) {
+            if (level == steps / 2) throw Interrupted();
+        }, watch);
+    } catch (const Interrupted&) {
+    }
+    CheckpointHeader stored;
+    std::vector<double> storedRow;
+    const int from = readCheckpoint("bench_checkpoint.wck", stored, storedRow) ? static_cast<int>(stored.level) : 0;
+    std::vector<double> resumed;
+    double seconds = bestOf(1, [&]() {
+        WaveEquationSolver solver(input);
+        solver.setCheckpoint("bench_checkpoint.wck", 100);
+        solver.solve(WaveEquationSolver::Lax_Wendroff, [&](int, double, const double* row, int n) { resumed.assign(row, row + n); }, policy);
+    });
+    const bool identical = resumed.size() == reference.size() &&
+                           std::memcmp(resumed.data(), reference.data(), reference.size() * sizeof(double)) == 0;
+    std::string name = "resumed from level " + std::to_string(from);
+    std::printf("  %-28s %8.4f s  last level %s\n", name.c_str(), seconds, identical ? "bit-identical" : "DIFFERS");
+    std::remove("bench_checkpoint.wck");
+}
+
+/// @brief Compressed output: .wes against lossless and lossy .wez (ratio, error, random and sequential reads)
+void benchCompression() {
+    Input input = {1.75, 100, -50, 50, 2, 20000, 0.8, {SET2_Function, 0, 0}};
+    std::cout << "Compressed output (LW, N = " << input.N << ", " << WaveEquationSolver(input).stepCount(WaveEquationSolver::Lax_Wendroff)
+              << " levels written)\n";
+    double plain = bestOf(3, [&]() {
+        WaveEquationSolver solver(input);
+        BinarySink file("bench_output.wes");
+        solver.solve(WaveEquationSolver::Lax_Wendroff, file);
+    });
+    std::printf("  %-28s %8.4f s\n", ".wes", plain);
+    ResultFile reference;
+    reference.open("bench_output.wes");
+    for (double tolerance : {0.0, 1e-9, 1e-6, 1e-3}) {
+        CompressionMetrics metrics;
+        double seconds = bestOf(3, [&]() {
+            WaveEquationSolver solver(input);
+            CompressedSink file("bench_output.wez", tolerance);
+            solver.solve(WaveEquationSolver::Lax_Wendroff, file);
+            metrics = file.metrics();
+        });
+        // One level on demand (the middle one) against the whole file in order
+        CompressedResultFile compressed;
+        compressed.open("bench_output.wez");
+        std::vector<double> row(input.N);
+        double maxError = 0;
+        double one = bestOf(5, [&]() {
+            compressed.close();
+            compressed.open("bench_output.wez");
+            compressed.readRow(compressed.rows() / 2, row.data());
+        });
+        double all = bestOf(3, [&]() {
+            for (int64_t i = 0; i < compressed.rows(); i++) {
+                compressed.readRow(i, row.data());
+                for (int64_t j = 0; j < compressed.N(); j++) maxError = std::max(maxError, std::fabs(row[j] - reference.row(i)[j]));
+            }
+        });
+        char name[32];
+        std::snprintf(name, sizeof(name), tolerance > 0 ? "tolerance %g" : "lossless", tolerance);
+        std::printf("  %-28s %8.4f s  ratio %5.1f, encode %.4f s, max error %.2e, one level %.2e s, all levels %.4f s\n", name,
+                    seconds, metrics.ratio(), metrics.compressSeconds, maxError, one, all);
+    }
+    reference.close();
+    std::remove("bench_output.wes");
+    std::remove("bench_output.wez");
+}
+
+/// @brief Level-of-detail pyramid: cost of writing the .lod, and a whole-run view from it against a full-resolution scan
+void benchPyramid() {
+    Input input = {1.75, 100, -50, 50, 2, 20000, 0.8, {SET2_Function, 0, 0}};
+    std::cout << "Level-of-detail pyramid (LW, N = " << input.N << ", " << WaveEquationSolver(input).stepCount(WaveEquationSolver::Lax_Wendroff)
+              << " levels written)\n";
+    double plain = bestOf(3, [&]() {
+        WaveEquationSolver solver(input);
+        BinarySink file("bench_output.wes");
+        solver.solve(WaveEquationSolver::Lax_Wendroff, file);
+    });
+    double withPyramid = bestOf(3, [&]() {
+        WaveEquationSolver solver(input);
+        BinarySink file("bench_output.wes");
+        PyramidSink lod("bench_output.lod");
+        TeeSink tee({&file, &lod});
+        solver.solve(WaveEquationSolver::Lax_Wendroff, tee);
+    });
+    std::printf("  %-28s %8.4f s\n", ".wes", plain);
+    std::printf("  %-28s %8.4f s\n", ".wes + .lod", withPyramid);
+
+    // A 1000 x 250 view of the whole run: every full-resolution value against one pyramid level
+    ResultFile full;
+    full.open("bench_output.wes");
+    double sum = 0;
+    double scan = bestOf(3, [&]() {
+        for (int64_t i = 0; i < full.rows(); i++) {
+            for (int64_t j = 0; j < full.N(); j++) sum += full.row(i)[j];
+        }
+    });
+    PyramidFile pyramid;
+    pyramid.open("bench_output.lod");
+    int level = 0;
+    double view = bestOf(3, [&]() {
+        level = pyramid.choose(250, 1000, 0, 1e300);
+        int64_t first, count;
+        pyramid.rows(level, 0, 1e300, first, count);
+        for (int64_t i = first; i < first + count; i++) {
+            for (int64_t c = 0; c < pyramid.level(level).columns; c++) sum += pyramid.mean(level, i)[c];
+        }
+    });
+    std::printf("  %-28s %8.4f s  (%lld x %lld values)\n", "view from .wes", scan, static_cast<long long>(full.rows()),
+                static_cast<long long>(full.N()));
+    std::printf("  %-28s %8.4f s  (level %d: %lld x %lld cells, checksum %.3g)\n", "view from .lod", view, level,
+                static_cast<long long>(pyramid.level(level).rows), static_cast<long long>(pyramid.level(level).columns), sum);
+    std::ifstream wes("bench_output.wes", std::ios::binary | std::ios::ate), lodFile("bench_output.lod", std::ios::binary | std::ios::ate);
+    std::printf("  %-28s %8.1f %%\n", ".lod size / .wes size", 100.0 * lodFile.tellg() / wes.tellg());
+    full.close();
+    pyramid.close();
+    std::remove("bench_output.wes");
+    std::remove("bench_output.lod");
+}
+
+/// @brief Mesh refinement against the uniform grid of the same finest spacing
+/// @note Final-time errors (L1 weighted by dx, LInf) against the advected initial
+///       profile, point updates and wall time, for each explicit scheme and set.
+void benchRefinement() {
+    const int base = 1000;
+    Refinement refinement;
+    refinement.levels = 3;
+    RecordPolicy policy;
+    policy.every = 0;
+    policy.last = true;
+    std::cout << "Mesh refinement (N = " << base << " with " << refinement.levels << " levels of ratio " << refinement.ratio
+              << " against N = " << base * refinement.scale() << ", t_max = 10)\n";
+    const Bondary sets[2] = {{SET1_Function, 0, 1}, {SET2_Function, 0, 0}};
+    const WaveEquationSolver::Scheme schemes[3] = {WaveEquationSolver::E_FTBS, WaveEquationSolver::Lax_Wendroff,
+                                                   WaveEquationSolver::Richtmyer_MultiStep};
+    std::printf("  %-20s %-8s %11s %11s %9s %12s\n", "case", "grid", "L1 error", "LInf error", "time (s)", "updates");
+    for (const Bondary& bondary : sets) {
+        for (WaveEquationSolver::Scheme scheme : schemes) {
+            const std::string name = WaveEquationSolver::schemeName(scheme) + " " + bondaryName(bondary);
+            for (bool refined : {false, true}) {
+                Input input = {1.75, 100, -50, 50, 10, refined ? base : base * refinement.scale(), 0.5, bondary};
+                NormRecord error = {};
+                long long updates = 0;
+                double seconds = bestOf(3, [&]() {
+                    WaveEquationSolver solver(input);
+                    if (refined) solver.setRefinement(refinement);
+                    NormSink norms({Norms::NormType::L1, Norms::NormType::LInf}, 2.5, solver.exactSolution(), true);
+                    solver.solve(scheme, norms, policy);
+                    error = norms.last();
+                    updates = refined ? solver.refinementStats.pointsUpdated
+                                      : static_cast<long long>(solver.stepCount(scheme)) * input.N;
+                });
+                std::printf("  %-20s %-8s %11.4e %11.4e %9.4f %12lld\n", name.c_str(), refined ? "refined" : "uniform",
+                            error.l1, error.linf, seconds, updates);
+            }
+        }
+    }
+}
+
+/// @struct SuiteOptions
+/// @brief Command-line options of the suite
+struct SuiteOptions {
+    int repetitions = 5;           ///< Timed runs per case (after one warm-up run)
+    long long maxN = 10000000;     ///< Largest problem size
+    std::string json = "benchmarks.json"; ///< Machine-readable results
+};
+
+/// @struct CaseResult
+/// @brief Timings of one suite case
+struct CaseResult {
+    std::string group;            ///< solve, norms, io
+    std::string name;             ///< Case name
+    long long n;                  ///< Problem size (points or values)
+    double items;                 ///< Points or values processed per run
+    double bytes;                 ///< Bytes read or written per run (0: not applicable)
+    std::vector<double> seconds;  ///< Wall time of each timed run
+    long long peakRSS;            ///< Peak resident set size during the case, bytes (0: unknown)
+
+    double mean() const {
+        double sum = 0;
+        for (double t : seconds) sum += t;
+        return sum / seconds.size();
+    }
+
+    /// @brief Sample standard deviation of the run times
+    double stddev() const {
+        if (seconds.size() < 2) return 0;
+        const double m = mean();
+        double sum = 0;
+        for (double t : seconds) sum += (t - m) * (t - m);
+        return std::sqrt(sum / (seconds.size() - 1));
+    }
+
+    double best() const { return *std::min_element(seconds.begin(), seconds.end()); }
+};
+
+/// @brief Resets the peak RSS of the process (Linux: /proc/self/clear_refs)
+void resetPeakRSS() {
+#ifdef __linux__
+    std::ofstream out("/proc/self/clear_refs");
+    if (out.is_open()) out << "5";
+#endif
+}
+
+/// @brief Peak resident set size of the process in bytes since the last reset
+long long peakRSS() {
+#ifdef __linux__
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoll(line.substr(6)) * 1024;
+        }
+    }
+#endif
+    return 0;
+}
+
+/// @brief Times a case: one warm-up run, then `repetitions` timed runs
+CaseResult measure(const std::string& group, const std::string& name, long long n, double items, double bytes,
+                   int repetitions, const std::function<void()>& run) {
+    CaseResult result{group, name, n, items, bytes, {}, 0};
+    resetPeakRSS();
+    run();
+    for (int r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.seconds.push_back(elapsed.count());
+    }
+    result.peakRSS = peakRSS();
+    std::printf("  %-24s %9lld %11.4f ms +-%5.1f%% %10.2f Mitems/s", name.c_str(), n, 1e3 * result.mean(),
+                100 * result.stddev() / result.mean(), items / result.best() / 1e6);
+    if (bytes > 0) std::printf(" %9.1f MB/s", bytes / result.best() / 1e6);
+    else std::printf(" %14s", "");
+    std::printf(" %8.1f MB RSS\n", result.peakRSS / 1e6);
+    return result;
+}
+
+/// @brief Writes the suite results as JSON
+void writeSuiteJSON(const std::string& filename, const SuiteOptions& options, const std::vector<CaseResult>& results) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return;
+    }
+    out << std::setprecision(9);
+    out << "{\n  \"context\": {\"compiler\": \"" << __VERSION__ << "\", \"simd\": \"" << simdName(simdBest())
+        << "\", \"threads\": " << std::thread::hardware_concurrency() << ", \"repetitions\": " << options.repetitions << "},\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const CaseResult& r = results[i];
+        out << "    {\"group\": \"" << r.group << "\", \"name\": \"" << r.name << "\", \"n\": " << r.n
+            << ", \"mean_s\": " << r.mean() << ", \"stddev_s\": " << r.stddev() << ", \"min_s\": " << r.best()
+            << ", \"items_per_s\": " << r.items / r.best() << ", \"bytes_per_s\": " << r.bytes / r.best()
+            << ", \"peak_rss_bytes\": " << r.peakRSS << ", \"seconds\": [";
+        for (size_t k = 0; k < r.seconds.size(); k++) out << (k ? ", " : "") << r.seconds[k];
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+/// @brief Regression suite: every scheme over N = 1e2 .. maxN, every Norms function and the I/O paths
+/// @note Solve cases stream to a sink that keeps nothing, with u chosen so each run
+///       updates about 2e7 points (at least 10 steps), so the timings are the
+///       schemes alone. Means, relative standard deviations and throughputs are
+///       printed; the JSON file also keeps every run time for regression tracking.
+void benchSuite(const SuiteOptions& options) {
+    std::vector<CaseResult> results;
+    const int reps = options.repetitions;
+    Bondary set2 = {SET2_Function, 0, 0};
+    RecordPolicy lastOnly;
+    lastOnly.every = 0;
+    lastOnly.last = true;
+
+    std::cout << "Suite: " << std::setw(24) << std::left << "case" << std::right << " N, mean time +- rel. stddev, throughput, peak RSS\n";
+    const WaveEquationSolver::Scheme schemes[] = {WaveEquationSolver::E_FTBS, WaveEquationSolver::I_FTBS, WaveEquationSolver::Lax_Wendroff,
+                                                  WaveEquationSolver::Richtmyer_MultiStep, WaveEquationSolver::BTCS,
+                                                  WaveEquationSolver::Crank_Nicolson};
+    for (WaveEquationSolver::Scheme scheme : schemes) {
+        for (long long N = 100; N <= options.maxN; N *= 10) {
+            const double dx = 100.0 / N;
+            const double steps = std::max(10.0, std::round(2e7 / N));
+            Input input = {steps * 0.8 * dx, 100, -50, 50, 1, static_cast<int>(N), 0.8, set2};
+            WaveEquationSolver solver(input);
+            const double items = static_cast<double>(N) * solver.stepCount(scheme);
+            DiscardSink discard;
+            results.push_back(measure("solve", "solve/" + WaveEquationSolver::schemeName(scheme), N, items, 0, reps,
+                                      [&]() { solver.solve(scheme, discard, lastOnly); }));
+        }
+    }
+
+    for (long long n = 1000; n <= options.maxN; n *= 100) {
+        std::vector<long double> legacy(static_cast<size_t>(n));
+        std::vector<double> values(static_cast<size_t>(n));
+        for (long long i = 0; i < n; i++) {
+            values[i] = SET2_Function(-5.0 + 10.0 * i / n) - 0.25;
+            legacy[i] = values[i];
+        }
+        const double bytes = static_cast<double>(n * sizeof(long double));
+        long double sink = 0;
+        results.push_back(measure("norms", "Norms::L1", n, n, bytes, reps, [&]() { sink += Norms::L1(legacy); }));
+        results.push_back(measure("norms", "Norms::L2", n, n, bytes, reps, [&]() { sink += Norms::L2(legacy); }));
+        results.push_back(measure("norms", "Norms::LInf", n, n, bytes, reps, [&]() { sink += Norms::LInf(legacy); }));
+        results.push_back(measure("norms", "Norms::Lp(2.5)", n, n, bytes, reps, [&]() { sink += Norms::Lp(legacy, 2.5); }));
+        results.push_back(measure("norms", "Norms::Normalize(L2)", n, n, bytes, reps,
+                                  [&]() { sink += Norms::Normalize(legacy, Norms::NormType::L2); }));
+        results.push_back(measure("norms", "FusedNorms::compute", n, n, n * sizeof(double), reps,
+                                  [&]() { sink += FusedNorms::compute(values, 2.5, 1).L2(); }));
+        results.push_back(measure("norms", "Norms::interpolate(ld)", n, 2 * n, 3 * bytes, reps,
+                                  [&]() { sink += Norms::interpolate(legacy, 2 * n)[n / 2]; }));
+        results.push_back(measure("norms", "Norms::interpolate", n, 2 * n, 3 * n * sizeof(double), reps,
+                                  [&]() { sink += Norms::interpolate(values, 2 * n)[n / 2]; }));
+        results.push_back(measure("norms", "Norms::interpolate(cub)", n, 2 * n, 3 * n * sizeof(double), reps,
+                                  [&]() { sink += Norms::interpolate(values, 2 * n, ResamplePlan::Method::Cubic)[n / 2]; }));
+        if (sink == 42) std::cout << "";
+    }
+
+    // I/O: the CSV paths of main and NormsProduction and the binary format
+    Input input = {1.75, 100.0, -50.0, 50.0, 10, static_cast<int>(std::min<long long>(2000, options.maxN)), 0.5, set2};
+    WaveEquationSolver solver(input);
+    solver.solve(WaveEquationSolver::Lax_Wendroff, [&](int, double, const double* row, int n) { solver.matrix.emplace_back(row, row + n); });
+    const long long values = static_cast<long long>(solver.matrix.size()) * input.N;
+    const std::string csv = "bench_suite.csv";
+    const std::string wes = "bench_suite.wes";
+    solver.writeMatixToCSV(csv);
+    const double csvBytes = static_cast<double>(fileSize(csv));
+    results.push_back(measure("io", "writeMatixToCSV", values, values, csvBytes, reps, [&]() { solver.writeMatixToCSV(csv); }));
+    results.push_back(measure("io", "readFColumn", values, values, csvBytes, reps, [&]() {
+        std::vector<double> f;
+        CSVColumnReader reader(1);
+        reader.read(csv, "f", f);
+    }));
+    results.push_back(measure("io", "readFColumn (legacy)", values, values, csvBytes, reps, [&]() { readLegacyFColumn(csv); }));
+    results.push_back(measure("io", "BinarySink", values, values, values * sizeof(double), reps, [&]() {
+        BinarySink binary(wes);
+        solver.solve(WaveEquationSolver::Lax_Wendroff, binary);
+    }));
+    results.push_back(measure("io", "ResultFile read", values, values, values * sizeof(double), reps, [&]() {
+        ResultFile file;
+        double sum = 0;
+        if (file.open(wes)) {
+            for (int64_t i = 0; i < file.rows(); i++) sum += file.row(i)[file.N() / 2];
+        }
+        if (sum == 42) std::cout << "";
+    }));
+    std::remove(csv.c_str());
+    std::remove(wes.c_str());
+
+    writeSuiteJSON(options.json, options, results);
+    std::cout << "  " << results.size() << " cases written to " << options.json << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    // Optional arguments: name of a single benchmark to run, and the suite options
+    std::string only;
+    SuiteOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--json=", 0) == 0) {
+            options.json = arg.substr(7);
+        } else if (arg.rfind("--reps=", 0) == 0) {
+            options.repetitions = std::max(1, std::stoi(arg.substr(7)));
+        } else if (arg.rfind("--max-n=", 0) == 0) {
+            options.maxN = static_cast<long long>(std::stod(arg.substr(8)));
+        } else {
+            only = arg;
+        }
+    }
+
+    if (only.empty() || only == "csv") benchCSVWriters();
+    if (only.empty() || only == "csv_read") benchCSVReader();
+    if (only.empty() || only == "blocking") benchTemporalBlocking();
+    bool ok = true;
+    if (only.empty() || only == "simd") ok = benchSimd() && ok;
+    if (only.empty() || only == "norms") benchNorms();
+    if (only.empty() || only == "resample") benchResample();
+    if (only.empty() || only == "batch") benchBatch();
+    if (only.empty() || only == "banded") benchBanded();
+    if (only.empty() || only == "checkpoint") benchCheckpoint();
+    if (only.empty() || only == "async") benchAsyncOutput();
+    if (only.empty() || only == "compress") benchCompression();
+    if (only.empty() || only == "lod") benchPyramid();
+    if (only.empty() || only == "amr") benchRefinement();
+    if (only.empty() || only == "suite") benchSuite(options);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <vector>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#ifdef _WIN32
+#include <direct.h> // For _mkdir on Windows
+#else
+#include <sys/stat.h> // For mkdir on Linux/Mac
+#endif
+
+#include "./Tools/WaveEquationSolver.cpp" // Include the WaveEquationSolver implementation
+#include "./Tools/Convergence.cpp" // Grid-convergence studies
+
+/// @brief Creates a folder in the file system (an existing folder is fine)
+/// @param folder Name of the folder to be created
+void createFolder(const std::string& folder) {
+#ifdef _WIN32
+    _mkdir(folder.c_str());
+#else
+    mkdir(folder.c_str(), 0777);
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    ConvergenceOptions options;
+    int set = 2;      // Smooth Gaussian by default: the step of SET1 caps every scheme near order 1/2
+    int t_max = 10;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--levels=", 0) == 0) {
+            options.maxLevels = std::stoi(arg.substr(9));
+        } else if (arg.rfind("--N0=", 0) == 0) {
+            options.N0 = std::stoi(arg.substr(5));
+        } else if (arg.rfind("--set=", 0) == 0) {
+            set = std::stoi(arg.substr(6));
+        } else if (arg.rfind("--t_max=", 0) == 0) {
+            t_max = std::stoi(arg.substr(8));
+        } else if (arg.rfind("--tolerance=", 0) == 0) {
+            options.tolerance = std::stod(arg.substr(12));
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            options.threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+        } else if (arg == "--reference=exact") {
+            options.reference = ConvergenceOptions::Exact;
+        } else if (arg == "--reference=richardson") {
+            options.reference = ConvergenceOptions::Richardson;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--levels=K] [--N0=N] [--set=1|2] [--t_max=T] [--tolerance=X] [--threads=K]"
+                         " [--reference=exact|richardson]" << std::endl;
+            return 1;
+        }
+    }
+
+    Bondary SET1_SIGN = {SET1_Function, 0, 1};
+    Bondary SET2_EXP = {SET2_Function, 0, 0};
+    Input base = {1.75, 100.0, -50.0, 50.0, t_max, options.N0, 0.5, (set == 1) ? SET1_SIGN : SET2_EXP};
+
+    std::string folder = "Results";
+    createFolder(folder);
+    std::string filename = folder + "/Convergence_" + bondaryName(base.bondary) + ".csv";
+    std::ofstream table(filename);
+    if (!table.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return 1;
+    }
+
+    // Refine every scheme until its observed order settles; only the norms are kept
+    ConvergenceStudy study(base, options);
+    bool header = true;
+    for (WaveEquationSolver::Scheme scheme : {WaveEquationSolver::E_FTBS, WaveEquationSolver::I_FTBS,
+                                              WaveEquationSolver::Lax_Wendroff, WaveEquationSolver::Richtmyer_MultiStep,
+                                              WaveEquationSolver::BTCS, WaveEquationSolver::Crank_Nicolson}) {
+        std::vector<ConvergenceLevel> levels = study.run(scheme);
+        std::string name = WaveEquationSolver::schemeName(scheme);
+        study.writeTable(table, name, levels, header);
+        header = false;
+
+        const ConvergenceLevel& last = levels.back();
+        std::printf("%-10s %d levels (N = %d..%d)  order L1 %.3f  L2 %.3f  LInf %.3f  %s\n", name.c_str(),
+                    static_cast<int>(levels.size()), levels.front().N, last.N, last.order.l1, last.order.l2, last.order.linf,
+                    study.reachedAsymptotic() ? "asymptotic" : "not settled");
+    }
+
+    std::cout << "Convergence table written to " << filename << std::endl;
+    return 0;
+}
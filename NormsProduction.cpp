@@ -4,70 +4,148 @@
 #include <vector>
 #include <string>
 #include <filesystem>
-#include <regex>
+#include <map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include "Tools/Norms.cpp"
+#include "Tools/ResultFile.cpp"
+#include "Tools/Compression.cpp"
+#include "Tools/CSVReader.cpp"
+#include "Tools/ThreadPool.cpp"
+#include "Tools/Profiler.cpp"
 
 namespace fs = std::filesystem;
 
-// Fonction pour lire la colonne "f" depuis un fichier CSV
-std::vector<long double> readFColumn(const std::string& filePath) {
-    std::ifstream file(filePath);
-    std::vector<long double> f_values;
-    std::string line;
+// Fonction pour lire la colonne "f" depuis un fichier CSV (fichier projeté en mémoire, analyse avec from_chars)
+std::vector<double> readFColumn(const std::string& filePath) {
+    PROFILE_SCOPE("read_csv");
+    std::vector<double> f_values;
+    CSVColumnReader reader(1); // Un thread : les fichiers sont lus en parallèle
 
-    if (!file.is_open()) {
-        std::cerr << "Erreur : Impossible d'ouvrir le fichier " << filePath << std::endl;
+    if (!reader.read(filePath, "f", f_values)) {
         return f_values;
     }
 
-    // Sauter la première ligne (entêtes)
-    std::getline(file, line);
+    // Signaler les lignes mal formées (un seul message par ligne, les fichiers sont lus en parallèle) avec leur numéro au lieu d'interrompre la lecture
+    for (const CSVIssue& issue : reader.getIssues()) {
+        std::cerr << "Attention : " + filePath + ":" + std::to_string(issue.line) + " : " + issue.message + "\n";
+    }
+    if (reader.issueCount() > reader.getIssues().size()) {
+        std::cerr << "Attention : " + filePath + " : " + std::to_string(reader.issueCount()) + " lignes mal formées au total\n";
+    }
+
+    return f_values;
+}
+
+// Fonction pour lire toutes les valeurs f d'un fichier résultat binaire (.wes)
+std::vector<double> readResultValues(const std::string& filePath) {
+    PROFILE_SCOPE("read_binary");
+    std::vector<double> f_values;
+    ResultFile result;
+    if (!result.open(filePath)) {
+        return f_values;
+    }
+
+    f_values.reserve(static_cast<size_t>(result.rows() * result.N()));
+    for (int64_t i = 0; i < result.rows(); i++) {
+        for (int64_t j = 0; j < result.N(); j++) {
+            f_values.push_back(result.value(i, j));
+        }
+    }
+    return f_values;
+}
 
-    // Lire chaque ligne et extraire la colonne "f"
-    while (std::getline(file, line)) {
-        std::istringstream ss(line);
-        std::string x, t, f;
-        std::getline(ss, x, ','); // Lire x
-        std::getline(ss, t, ','); // Lire t
-        std::getline(ss, f, ','); // Lire f
-        f_values.push_back(std::stold(f));
+// Fonction pour lire toutes les valeurs f d'un fichier résultat compressé (.wez), niveau par niveau
+std::vector<double> readCompressedValues(const std::string& filePath) {
+    PROFILE_SCOPE("read_compressed");
+    std::vector<double> f_values;
+    CompressedResultFile result;
+    if (!result.open(filePath)) {
+        return f_values;
     }
 
+    f_values.resize(static_cast<size_t>(result.rows() * result.N()));
+    for (int64_t i = 0; i < result.rows(); i++) {
+        if (!result.readRow(i, f_values.data() + i * result.N())) {
+            f_values.clear();
+            break;
+        }
+    }
     return f_values;
 }
 
+// Vrai si c est un caractère de \w (lettre, chiffre ou '_')
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Vrai si [begin, end) est une suite non vide de chiffres
+bool allDigits(const std::string& s, size_t begin, size_t end) {
+    if (begin >= end) return false;
+    for (size_t i = begin; i < end; i++) {
+        if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+    }
+    return true;
+}
+
 // Fonction pour extraire le schéma, le type de set, les échantillons et tmax à partir du nom de fichier
+// Analyse écrite à la main, équivalente à l'expression régulière (\w+)_SET(\d+)_(\w+)_(\d+)_(\d+)
+// (le premier groupe est glouton : c'est la dernière occurrence de "_SET<chiffres>_" qui compte)
 void extractFileInfo(const std::string& fileName, std::string& scheme, std::string& setType, int& samples, int& tmax) {
-    // Utilisation d'une expression régulière pour extraire les informations
-    std::regex regexPattern(R"((\w+)_SET(\d+)_(\w+)_(\d+)_(\d+))");
-    std::smatch match;
-
-    if (std::regex_match(fileName, match, regexPattern) && match.size() == 6) {
-        scheme = match[1];                   // Exemple : "E_FTBS"
-        setType = match[3];                  // Exemple : "sign" ou "exp"
-        samples = std::stoi(match[4]);       // Exemple : 100, 200, etc.
-        tmax = std::stoi(match[5]);          // Exemple : 5, 10, etc.
-    } else {
-        scheme = "Unknown";
-        setType = "Unknown";
-        samples = 0;
-        tmax = 0;
+    scheme = "Unknown";
+    setType = "Unknown";
+    samples = 0;
+    tmax = 0;
+
+    if (!std::all_of(fileName.begin(), fileName.end(), isWordChar)) return;
+
+    // Les deux derniers champs numériques : _<samples>_<tmax>
+    size_t last = fileName.rfind('_');
+    if (last == std::string::npos || last == 0 || !allDigits(fileName, last + 1, fileName.size())) return;
+    size_t prev = fileName.rfind('_', last - 1);
+    if (prev == std::string::npos || !allDigits(fileName, prev + 1, last)) return;
+
+    for (size_t pos = fileName.rfind("_SET", prev); pos != std::string::npos && pos > 0;
+         pos = fileName.rfind("_SET", pos - 1)) {
+        size_t digits = pos + 4;
+        size_t end = digits;
+        while (end < prev && std::isdigit(static_cast<unsigned char>(fileName[end]))) end++;
+        // Il faut au moins un chiffre, puis '_' et un type de set non vide avant les champs numériques
+        if (end == digits || end + 1 >= prev || fileName[end] != '_') continue;
+
+        scheme = fileName.substr(0, pos);                         // Exemple : "E_FTBS"
+        setType = fileName.substr(end + 1, prev - end - 1);      // Exemple : "sign" ou "exp"
+        samples = std::stoi(fileName.substr(prev + 1, last - prev - 1)); // Exemple : 100, 200, etc.
+        tmax = std::stoi(fileName.substr(last + 1));               // Exemple : 5, 10, etc.
+        return;
     }
 }
 
-// Fonction pour calculer les normes et les ajouter au fichier consolidé
-void processCSV(const std::string& inputPath, std::ofstream& outputFile) {
-    std::vector<long double> f_values = readFColumn(inputPath);
+// Fonction pour calculer les normes d'un fichier résultat ; renvoie la ligne du fichier consolidé (vide en cas d'erreur)
+std::string processFile(const std::string& inputPath) {
+    PROFILE_SCOPE("process_file");
+    const fs::path extension = fs::path(inputPath).extension();
+    std::vector<double> f_values = (extension == ".wes")   ? readResultValues(inputPath)
+                                   : (extension == ".wez") ? readCompressedValues(inputPath)
+                                                           : readFColumn(inputPath);
     if (f_values.empty()) {
-        std::cerr << "Erreur : Pas de données trouvées dans le fichier " << inputPath << std::endl;
-        return;
+        std::cerr << "Erreur : Pas de données trouvées dans le fichier " + inputPath + "\n";
+        return "";
     }
+    PROFILE_COUNT("values_read", f_values.size());
 
-    // Calcul des normes
-    long double l1 = Norms::L1(f_values);
-    long double l2 = Norms::L2(f_values);
-    long double linf = Norms::LInf(f_values);
-    long double lp = Norms::Lp(f_values, 2.5); // Exemple pour p = 2.5
+    // Calcul des normes en une seule passe (double précision, sommation compensée) ;
+    // un seul thread par fichier, les fichiers sont déjà traités en parallèle
+    NormAccumulator norms;
+    {
+        PROFILE_SCOPE("norms");
+        norms = FusedNorms::compute(f_values, 2.5, 1); // Exemple pour p = 2.5
+    }
+    double l1 = norms.L1();
+    double l2 = norms.L2();
+    double linf = norms.LInf();
+    double lp = norms.Lp();
 
     // Extraire le nom du fichier sans extension
     std::string fileName = fs::path(inputPath).stem().string();
@@ -77,11 +155,68 @@ void processCSV(const std::string& inputPath, std::ofstream& outputFile) {
     int samples, tmax;
     extractFileInfo(fileName, scheme, setType, samples, tmax);
 
-    // Ajouter les résultats au fichier CSV consolidé
-    outputFile << fileName << "," << scheme << "," << setType << "," << samples << "," << tmax << ","
-               << l1 << "," << l2 << "," << linf << "," << lp << "\n";
+    // Ligne du fichier CSV consolidé
+    std::ostringstream row;
+    row << fileName << "," << scheme << "," << setType << "," << samples << "," << tmax << ","
+        << l1 << "," << l2 << "," << linf << "," << lp;
+    return row.str();
 }
 
+// Cache des lignes déjà calculées, indexé par chemin, taille et date de modification
+class NormsCache {
+public:
+    struct Entry {
+        uintmax_t size;
+        long long mtime;
+        std::string row;
+    };
+
+    // Lecture du cache (une ligne par fichier : chemin, taille, date, ligne consolidée séparés par des tabulations)
+    void load(const fs::path& cachePath) {
+        std::ifstream in(cachePath);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            std::string path, size, mtime, row;
+            if (std::getline(ss, path, '\t') && std::getline(ss, size, '\t') && std::getline(ss, mtime, '\t') &&
+                std::getline(ss, row)) {
+                entries[path] = Entry{std::stoull(size), std::stoll(mtime), row};
+            }
+        }
+    }
+
+    void save(const fs::path& cachePath) const {
+        std::ofstream out(cachePath);
+        for (const auto& item : entries) {
+            out << item.first << "\t" << item.second.size << "\t" << item.second.mtime << "\t" << item.second.row << "\n";
+        }
+    }
+
+    // Ligne en cache si le fichier n'a pas changé
+    const std::string* find(const std::string& path, uintmax_t size, long long mtime) const {
+        auto it = entries.find(path);
+        if (it == entries.end() || it->second.size != size || it->second.mtime != mtime) return nullptr;
+        return &it->second.row;
+    }
+
+    void store(const std::string& path, uintmax_t size, long long mtime, const std::string& row) {
+        entries[path] = Entry{size, mtime, row};
+    }
+
+    // Oublie les fichiers qui n'existent plus
+    void keepOnly(const std::vector<std::string>& paths) {
+        std::map<std::string, Entry> kept;
+        for (const std::string& path : paths) {
+            auto it = entries.find(path);
+            if (it != entries.end()) kept.insert(*it);
+        }
+        entries.swap(kept);
+    }
+
+private:
+    std::map<std::string, Entry> entries;
+};
+
 // Fonction principale
 int main() {
     fs::path inputFolder = "Results";
@@ -98,26 +233,83 @@ int main() {
         fs::create_directory(outputFolder);
     }
 
-    // Ouvrir le fichier consolidé pour écriture
-    std::ofstream outputFile(outputFilePath);
-    if (!outputFile.is_open()) {
-        std::cerr << "Erreur : Impossible de créer le fichier " << outputFilePath << std::endl;
-        return 1;
+    // Lister les fichiers résultats (.wes, sinon .wez, sinon .csv), triés pour un ordre de sortie déterministe
+    std::vector<std::string> files;
+    {
+        PROFILE_SCOPE("scan");
+        for (const auto& entry : fs::directory_iterator(inputFolder)) {
+            fs::path binary = entry.path();
+            binary.replace_extension(".wes");
+            fs::path compressed = entry.path();
+            compressed.replace_extension(".wez");
+            bool isBinary = entry.path().extension() == ".wes";
+            bool isCompressed = entry.path().extension() == ".wez" && !fs::exists(binary);
+            bool isCSV = entry.path().extension() == ".csv" && entry.path().filename() != "Norms.csv" && !fs::exists(binary) &&
+                         !fs::exists(compressed);
+            if (isBinary || isCompressed || isCSV) {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
     }
 
-    // Écrire les en-têtes
-    outputFile << "FileName,Scheme,SetType,Samples,Tmax,L1,L2,LInf,Lp(p=2.5)\n";
+    // Les fichiers inchangés depuis le dernier passage reprennent leur ligne du cache
+    fs::path cachePath = outputFolder / ".norms_cache";
+    NormsCache cache;
+    {
+        PROFILE_SCOPE("cache_load");
+        cache.load(cachePath);
+        cache.keepOnly(files);
+    }
 
-    // Traiter chaque fichier CSV dans le dossier d'entrée
-    for (const auto& entry : fs::directory_iterator(inputFolder)) {
-        if (entry.path().extension() == ".csv" && entry.path().filename() != "Norms.csv") {
-            std::cout << "Traitement du fichier : " << entry.path() << std::endl;
-            processCSV(entry.path().string(), outputFile);
+    std::vector<std::string> rows(files.size());
+    std::vector<uintmax_t> sizes(files.size());
+    std::vector<long long> mtimes(files.size());
+    size_t processed = 0;
+    {
+        ThreadPool pool;
+        for (size_t i = 0; i < files.size(); i++) {
+            std::error_code error;
+            sizes[i] = fs::file_size(files[i], error);
+            mtimes[i] = static_cast<long long>(fs::last_write_time(files[i], error).time_since_epoch().count());
+            if (const std::string* row = cache.find(files[i], sizes[i], mtimes[i])) {
+                rows[i] = *row;
+                PROFILE_COUNT("files_cached", 1);
+                continue;
+            }
+            PROFILE_COUNT("bytes_read", sizes[i]);
+            std::cout << "Traitement du fichier : " << files[i] << std::endl;
+            processed++;
+            pool.submit([&rows, &files, i]() { rows[i] = processFile(files[i]); });
         }
+        pool.wait();
     }
 
-    outputFile.close();
+    {
+        PROFILE_SCOPE("write_output");
+        // Ouvrir le fichier consolidé pour écriture
+        std::ofstream outputFile(outputFilePath);
+        if (!outputFile.is_open()) {
+            std::cerr << "Erreur : Impossible de créer le fichier " << outputFilePath << std::endl;
+            return 1;
+        }
+
+        // Écrire les en-têtes puis les lignes dans l'ordre des noms de fichiers
+        outputFile << "FileName,Scheme,SetType,Samples,Tmax,L1,L2,LInf,Lp(p=2.5)\n";
+        for (size_t i = 0; i < files.size(); i++) {
+            if (rows[i].empty()) continue;
+            outputFile << rows[i] << "\n";
+            cache.store(files[i], sizes[i], mtimes[i], rows[i]);
+        }
+        cache.save(cachePath);
+
+        outputFile.close();
+    }
+    std::cout << processed << " fichier(s) traité(s), " << files.size() - processed << " repris du cache" << std::endl;
     std::cout << "Les normes ont été consolidées dans : " << outputFilePath << std::endl;
 
+    // Compilé avec -DWES_PROFILE : temps par étape, compteurs et trace Chrome
+    PROFILE_REPORT((outputFolder / "profile.json").string(), (outputFolder / "trace.json").string());
+
     return 0;
 }
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+#include "Output.cpp"
+#include "Profiler.cpp"
+
+/// @struct AsyncSinkMetrics
+/// @brief Counters of an AsyncSink run (read after `end`)
+struct AsyncSinkMetrics {
+    long long rows = 0;          ///< Levels passed through the queue
+    long long stalls = 0;        ///< Writes that found the queue full and waited
+    double stallSeconds = 0;     ///< Time the solver spent waiting for a free buffer
+    double writerSeconds = 0;    ///< Time the writer thread spent in the downstream sink
+    int capacity = 0;            ///< Number of pooled row buffers
+    int maxDepth = 0;            ///< Most levels queued at once
+    double meanDepth = 0;        ///< Average number of levels queued, sampled at each write
+};
+
+/// @class AsyncSink
+/// @brief Hands the recorded levels to a writer thread that feeds another sink
+/// @note The queue is a single-producer single-consumer ring of `capacity` row
+///       buffers allocated in `begin`; `write` copies the row into the next free
+///       buffer and publishes it with an atomic index, so no row is allocated and
+///       no lock is taken while both sides keep up. When the ring is full the
+///       solver waits for the writer (backpressure), and an idle writer sleeps.
+///       Either side is only woken once the ring is half drained or half full,
+///       so a stalled pipeline switches threads once per half ring, not per row.
+///       The downstream sink sees begin, every level in order and end exactly as
+///       it would from the solver, all its writes on the writer thread, so the
+///       solve costs max(compute, output) rather than their sum when the output
+///       waits on the disk or a core is free for the writer.
+class AsyncSink : public RowSink {
+public:
+    /// @brief Constructor
+    /// @param sink The downstream sink
+    /// @param capacity Number of pooled row buffers (queue depth)
+    AsyncSink(RowSink& sink, int capacity = 8) : sink(sink), capacity(std::max(2, capacity)) {}
+
+    AsyncSink(const AsyncSink&) = delete;
+    AsyncSink& operator=(const AsyncSink&) = delete;
+
+    ~AsyncSink() {
+        if (writer.joinable()) stop();
+    }
+
+    void begin(const RunInfo& info) override {
+        if (writer.joinable()) stop();
+        slots.resize(capacity);
+        for (Slot& slot : slots) slot.row.resize(std::max(0, info.N));
+        head.store(0);
+        tail.store(0);
+        finished = false;
+        stats = AsyncSinkMetrics();
+        stats.capacity = capacity;
+        depthSum = 0;
+        sink.begin(info);
+        writer = std::thread([this]() { work(); });
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) == slots.size()) {
+            // Backpressure: wait for the writer to release a buffer
+            PROFILE_SCOPE("output_stall");
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex);
+            producerWaiting.store(true);
+            freed.wait(lock, [&]() { return position - tail.load() <= slots.size() / 2; });
+            producerWaiting.store(false);
+            stats.stalls++;
+            stats.stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        Slot& slot = slots[position % slots.size()];
+        slot.level = level;
+        slot.t = t;
+        slot.n = std::min(n, static_cast<int>(slot.row.size()));
+        std::memcpy(slot.row.data(), row, slot.n * sizeof(double));
+        head.store(position + 1);
+        if (consumerWaiting.load() && position + 1 - tail.load() >= slots.size() / 2) {
+            std::lock_guard<std::mutex> lock(mutex);
+            filled.notify_one();
+        }
+
+        const int depth = static_cast<int>(position + 1 - tail.load(std::memory_order_relaxed));
+        stats.maxDepth = std::max(stats.maxDepth, depth);
+        depthSum += depth;
+        stats.rows++;
+    }
+
+    void end() override {
+        if (writer.joinable()) stop();
+        if (stats.rows > 0) stats.meanDepth = static_cast<double>(depthSum) / stats.rows;
+        sink.end();
+    }
+
+    /// @brief Counters of the last run (complete once `end` has returned)
+    const AsyncSinkMetrics& metrics() const { return stats; }
+
+private:
+    struct Slot {
+        int level = 0;
+        double t = 0;
+        int n = 0;
+        std::vector<double> row;
+    };
+
+    /// @brief Drains the queue and joins the writer
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+        }
+        filled.notify_one();
+        writer.join();
+    }
+
+    void work() {
+        double busy = 0;
+        while (true) {
+            const size_t position = tail.load(std::memory_order_relaxed);
+            if (position == head.load(std::memory_order_acquire)) {
+                std::unique_lock<std::mutex> lock(mutex);
+                consumerWaiting.store(true);
+                filled.wait(lock, [&]() { return finished || head.load() - position >= slots.size() / 2; });
+                consumerWaiting.store(false);
+                if (position == head.load()) break;
+            }
+            Slot& slot = slots[position % slots.size()];
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            sink.write(slot.level, slot.t, slot.row.data(), slot.n);
+            busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            tail.store(position + 1);
+            if (producerWaiting.load() && head.load() - (position + 1) <= slots.size() / 2) {
+                std::lock_guard<std::mutex> lock(mutex);
+                freed.notify_one();
+            }
+        }
+        stats.writerSeconds = busy;
+    }
+
+    RowSink& sink;
+    int capacity;
+    std::vector<Slot> slots;
+    alignas(64) std::atomic<size_t> head{0}; ///< Next buffer the solver fills
+    alignas(64) std::atomic<size_t> tail{0}; ///< Next buffer the writer drains
+    alignas(64) std::atomic<bool> producerWaiting{false};
+    std::atomic<bool> consumerWaiting{false};
+    std::mutex mutex;
+    std::condition_variable filled;
+    std::condition_variable freed;
+    bool finished = false;
+    std::thread writer;
+    AsyncSinkMetrics stats;
+    long long depthSum = 0;
+};
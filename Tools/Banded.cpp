@@ -0,0 +1,365 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "Parallel.cpp"
+
+// Linear solvers for the implicit schemes. Every solver is factorised once and then
+// applied to any number of right-hand sides in place, so a time step with constant
+// dt and dx costs one forward and one backward sweep. There is no pivoting: the
+// advection matrices have a unit diagonal and off-diagonals -a and +a, so every
+// Thomas pivot is 1 + a^2 / previous pivot >= 1 whatever the CFL number.
+
+/// @brief Index runs [first, second) holding the nonzero entries of a decaying vector
+/// @note Subnormal entries are flushed to zero first: the spikes and correction
+///       vectors decay geometrically away from the coupling, and their long
+///       subnormal tails would otherwise slow every solve down for a contribution
+///       below 1e-308. Loops over the runs skip the exact zeros.
+inline std::vector<std::pair<int, int>> nonZeroRuns(std::vector<double>& x) {
+    std::vector<std::pair<int, int>> runs;
+    const int n = static_cast<int>(x.size());
+    for (int i = 0; i < n; i++) {
+        if (std::fpclassify(x[i]) == FP_SUBNORMAL) x[i] = 0.0;
+        if (x[i] == 0.0) continue;
+        if (!runs.empty() && runs.back().second == i) {
+            runs.back().second = i + 1;
+        } else {
+            runs.push_back(std::make_pair(i, i + 1));
+        }
+    }
+    return runs;
+}
+
+/// @class BandedLU
+/// @brief LU factorisation without pivoting of a general banded matrix
+/// @note Stored by diagonals: band(i, d) is A[i][i + d] for d in [-kl, ku]. Used for
+///       the small reduced systems of the partitioned solver and for any band wider
+///       than three diagonals.
+class BandedLU {
+public:
+    BandedLU() {}
+
+    /// @brief Empty n x n matrix with kl sub- and ku super-diagonals
+    BandedLU(int n, int kl, int ku) : n(n), kl(kl), ku(ku), values(static_cast<size_t>(n) * (kl + ku + 1), 0.0) {}
+
+    /// @brief Entry A[i][i + d] (d in [-kl, ku]) before factor() is called
+    double& band(int i, int d) { return values[static_cast<size_t>(i) * (kl + ku + 1) + kl + d]; }
+    double band(int i, int d) const { return values[static_cast<size_t>(i) * (kl + ku + 1) + kl + d]; }
+
+    int size() const { return n; }
+
+    /// @brief Factorises in place: multipliers below the diagonal, U on and above it
+    void factor() {
+        for (int k = 0; k < n; k++) {
+            const double pivot = band(k, 0);
+            for (int i = k + 1; i <= std::min(n - 1, k + kl); i++) {
+                double& l = band(i, k - i);
+                l /= pivot;
+                for (int j = k + 1; j <= std::min(n - 1, k + ku); j++) {
+                    band(i, j - i) -= l * band(k, j - k);
+                }
+            }
+        }
+    }
+
+    /// @brief Solves A x = b in place (b becomes x)
+    void solve(double* x) const {
+        for (int i = 0; i < n; i++) {
+            double sum = x[i];
+            for (int j = std::max(0, i - kl); j < i; j++) sum -= band(i, j - i) * x[j];
+            x[i] = sum;
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            double sum = x[i];
+            for (int j = i + 1; j <= std::min(n - 1, i + ku); j++) sum -= band(i, j - i) * x[j];
+            x[i] = sum / band(i, 0);
+        }
+    }
+
+private:
+    int n = 0;
+    int kl = 0;
+    int ku = 0;
+    std::vector<double> values;
+};
+
+/// @class TridiagonalLU
+/// @brief Thomas algorithm: LU factorisation of a tridiagonal matrix
+/// @note Row i reads sub[i] x[i - 1] + diag[i] x[i] + super[i] x[i + 1] (sub[0] and
+///       super[n - 1] are ignored). The factorisation keeps the multipliers and the
+///       inverse pivots, so a solve is two sweeps with one multiply-add per point
+///       each and no division.
+class TridiagonalLU {
+public:
+    TridiagonalLU() {}
+
+    /// @brief Factorises a matrix given by its three diagonals
+    TridiagonalLU(const std::vector<double>& sub, const std::vector<double>& diag, const std::vector<double>& super) {
+        factor(sub, diag, super);
+    }
+
+    /// @brief Factorises a constant-coefficient (Toeplitz) matrix
+    static TridiagonalLU constant(int n, double sub, double diag, double super) {
+        return TridiagonalLU(std::vector<double>(n, sub), std::vector<double>(n, diag), std::vector<double>(n, super));
+    }
+
+    void factor(const std::vector<double>& sub, const std::vector<double>& diag, const std::vector<double>& super) {
+        const int n = static_cast<int>(diag.size());
+        lower.assign(n, 0.0);
+        inverse.assign(n, 0.0);
+        upper = super;
+        if (n == 0) return;
+        double pivot = diag[0];
+        inverse[0] = 1.0 / pivot;
+        for (int i = 1; i < n; i++) {
+            lower[i] = sub[i] * inverse[i - 1];
+            pivot = diag[i] - lower[i] * super[i - 1];
+            inverse[i] = 1.0 / pivot;
+        }
+    }
+
+    int size() const { return static_cast<int>(inverse.size()); }
+
+    /// @brief Solves A x = b in place (b becomes x)
+    void solve(double* x) const {
+        const int n = size();
+        if (n == 0) return;
+        const double* __restrict l = lower.data();
+        const double* __restrict inv = inverse.data();
+        const double* __restrict u = upper.data();
+        for (int i = 1; i < n; i++) {
+            x[i] -= l[i] * x[i - 1];
+        }
+        x[n - 1] *= inv[n - 1];
+        for (int i = n - 2; i >= 0; i--) {
+            x[i] = (x[i] - u[i] * x[i + 1]) * inv[i];
+        }
+    }
+
+private:
+    std::vector<double> lower;   ///< Multipliers sub[i] / pivot[i - 1]
+    std::vector<double> inverse; ///< 1 / pivot[i]
+    std::vector<double> upper;   ///< Super-diagonal
+};
+
+/// @class PeriodicTridiagonalLU
+/// @brief Cyclic tridiagonal solver for periodic boundaries (Sherman-Morrison)
+/// @note The corner entries A[0][n - 1] = sub[0] and A[n - 1][0] = super[n - 1] make
+///       the matrix cyclic. It is written as a tridiagonal matrix plus a rank-one
+///       update; the correction vector is solved once at factorisation, so a solve
+///       is one Thomas solve and one axpy.
+class PeriodicTridiagonalLU {
+public:
+    PeriodicTridiagonalLU() {}
+
+    /// @brief Factorises a cyclic matrix given by its three diagonals (n >= 3)
+    PeriodicTridiagonalLU(const std::vector<double>& sub, const std::vector<double>& diag, const std::vector<double>& super) {
+        const int n = static_cast<int>(diag.size());
+        const double top = sub[0];         // A[0][n - 1]
+        const double bottom = super[n - 1]; // A[n - 1][0]
+        gamma = -diag[0];
+        std::vector<double> modified = diag;
+        modified[0] = diag[0] - gamma;
+        modified[n - 1] = diag[n - 1] - bottom * top / gamma;
+        lu.factor(sub, modified, super);
+        beta = top;
+
+        // Correction z = A'^-1 u with u = (gamma, 0, ..., 0, bottom)
+        z.assign(n, 0.0);
+        z[0] = gamma;
+        z[n - 1] = bottom;
+        lu.solve(z.data());
+        denominator = 1.0 + z[0] + beta * z[n - 1] / gamma;
+        runs = nonZeroRuns(z);
+    }
+
+    /// @brief Factorises a constant-coefficient cyclic matrix
+    static PeriodicTridiagonalLU constant(int n, double sub, double diag, double super) {
+        return PeriodicTridiagonalLU(std::vector<double>(n, sub), std::vector<double>(n, diag), std::vector<double>(n, super));
+    }
+
+    int size() const { return static_cast<int>(z.size()); }
+
+    /// @brief Solves A x = b in place (b becomes x)
+    void solve(double* x) const {
+        const int n = size();
+        lu.solve(x);
+        const double factor = (x[0] + beta * x[n - 1] / gamma) / denominator;
+        for (const std::pair<int, int>& run : runs) {
+            for (int i = run.first; i < run.second; i++) {
+                x[i] -= factor * z[i];
+            }
+        }
+    }
+
+private:
+    TridiagonalLU lu;       ///< Factorisation of the modified tridiagonal part
+    std::vector<double> z;  ///< Correction vector
+    std::vector<std::pair<int, int>> runs; ///< Nonzero runs of z
+    double gamma = 0;
+    double beta = 0;
+    double denominator = 1;
+};
+
+/// @class SpikeTridiagonal
+/// @brief Partitioned (SPIKE) tridiagonal solver for large systems on several threads
+/// @note The unknowns are split into P contiguous partitions. Each partition is
+///       factorised on its own, along with its two spikes: the responses of the
+///       partition to its coupling with the last unknown of the previous partition
+///       (w) and the first unknown of the next one (v). A solve is three stages:
+///         1. local(p): Thomas solve of partition p (independent, in parallel);
+///         2. reduce(): the 2P top and bottom unknowns satisfy a small banded system,
+///            solved on one thread;
+///         3. correct(p): x_p -= v_p * top(p + 1) + w_p * bottom(p - 1) (in parallel).
+///       Rounding differs from a single Thomas sweep by a few ULP.
+class SpikeTridiagonal {
+public:
+    SpikeTridiagonal() {}
+
+    /// @brief Factorises a constant-coefficient matrix of n unknowns split in `parts` partitions
+    SpikeTridiagonal(int n, double sub, double diag, double super, int parts) {
+        parts = std::max(1, std::min(parts, n / 2));
+        bounds = splitRange(0, n, parts);
+        blocks.resize(parts);
+        v.resize(parts);
+        w.resize(parts);
+        for (int p = 0; p < parts; p++) {
+            const int m = bounds[p + 1] - bounds[p];
+            blocks[p] = TridiagonalLU::constant(m, sub, diag, super);
+            v[p].assign(m, 0.0);
+            w[p].assign(m, 0.0);
+            if (p + 1 < parts) {
+                v[p][m - 1] = super;
+                blocks[p].solve(v[p].data());
+            }
+            if (p > 0) {
+                w[p][0] = sub;
+                blocks[p].solve(w[p].data());
+            }
+        }
+
+        // Reduced system on (top_0, bottom_0, top_1, bottom_1, ...)
+        reduced = BandedLU(2 * parts, 2, 2);
+        for (int p = 0; p < parts; p++) {
+            const int m = bounds[p + 1] - bounds[p];
+            const int t = 2 * p, b = 2 * p + 1;
+            reduced.band(t, 0) = 1;
+            reduced.band(b, 0) = 1;
+            if (p + 1 < parts) {
+                reduced.band(t, 2) = v[p][0];     // top_p <- top_{p+1}
+                reduced.band(b, 1) = v[p][m - 1]; // bottom_p <- top_{p+1}
+            }
+            if (p > 0) {
+                reduced.band(t, -1) = w[p][0];     // top_p <- bottom_{p-1}
+                reduced.band(b, -2) = w[p][m - 1]; // bottom_p <- bottom_{p-1}
+            }
+        }
+        reduced.factor();
+        edges.assign(2 * parts, 0.0);
+        vRuns.resize(parts);
+        wRuns.resize(parts);
+        for (int p = 0; p < parts; p++) {
+            vRuns[p] = nonZeroRuns(v[p]);
+            wRuns[p] = nonZeroRuns(w[p]);
+        }
+    }
+
+    int partitions() const { return static_cast<int>(blocks.size()); }
+
+    /// @brief First unknown of partition p; partition p is [first(p), first(p + 1))
+    int first(int p) const { return bounds[p]; }
+
+    /// @brief Stage 1: local solve of partition p (x holds the right-hand side)
+    void local(int p, double* x) const {
+        blocks[p].solve(x + bounds[p]);
+    }
+
+    /// @brief Stage 2: solves for the partition edges (after every local solve)
+    void reduce(const double* x) {
+        const int parts = partitions();
+        for (int p = 0; p < parts; p++) {
+            edges[2 * p] = x[bounds[p]];
+            edges[2 * p + 1] = x[bounds[p + 1] - 1];
+        }
+        reduced.solve(edges.data());
+    }
+
+    /// @brief Stage 3: applies the coupling to partition p (after reduce)
+    void correct(int p, double* x) const {
+        const int parts = partitions();
+        double* part = x + bounds[p];
+        const double next = (p + 1 < parts) ? edges[2 * (p + 1)] : 0.0;
+        const double previous = (p > 0) ? edges[2 * p - 1] : 0.0;
+        const double* vp = v[p].data();
+        const double* wp = w[p].data();
+        for (const std::pair<int, int>& run : vRuns[p]) {
+            for (int i = run.first; i < run.second; i++) part[i] -= vp[i] * next;
+        }
+        for (const std::pair<int, int>& run : wRuns[p]) {
+            for (int i = run.first; i < run.second; i++) part[i] -= wp[i] * previous;
+        }
+    }
+
+    /// @brief Solves A x = b in place on the calling thread
+    void solve(double* x) {
+        for (int p = 0; p < partitions(); p++) local(p, x);
+        reduce(x);
+        for (int p = 0; p < partitions(); p++) correct(p, x);
+    }
+
+private:
+    std::vector<int> bounds;
+    std::vector<TridiagonalLU> blocks;
+    std::vector<std::vector<double>> v; ///< Response to top(p + 1)
+    std::vector<std::vector<double>> w; ///< Response to bottom(p - 1)
+    std::vector<std::vector<std::pair<int, int>>> vRuns; ///< Nonzero runs of v
+    std::vector<std::vector<std::pair<int, int>>> wRuns; ///< Nonzero runs of w
+    BandedLU reduced;
+    std::vector<double> edges;
+};
+
+/// @class TridiagonalCache
+/// @brief Keeps the last constant-coefficient factorisations of a solver
+/// @note Successive solves with the same n, coefficients and partition count reuse
+///       the factorisation instead of refactorising.
+class TridiagonalCache {
+public:
+    /// @brief Thomas factorisation of the n x n Toeplitz matrix (sub, diag, super)
+    const TridiagonalLU& thomas(int n, double sub, double diag, double super) {
+        if (!(thomasKey == Key{n, 1, sub, diag, super})) {
+            thomasLU = TridiagonalLU::constant(n, sub, diag, super);
+            thomasKey = Key{n, 1, sub, diag, super};
+        }
+        return thomasLU;
+    }
+
+    /// @brief Partitioned factorisation of the same matrix
+    SpikeTridiagonal& spike(int n, double sub, double diag, double super, int parts) {
+        if (!(spikeKey == Key{n, parts, sub, diag, super})) {
+            spikeLU = SpikeTridiagonal(n, sub, diag, super, parts);
+            spikeKey = Key{n, parts, sub, diag, super};
+        }
+        return spikeLU;
+    }
+
+private:
+    struct Key {
+        int n;
+        int parts;
+        double sub;
+        double diag;
+        double super;
+
+        bool operator==(const Key& other) const {
+            return n == other.n && parts == other.parts && sub == other.sub && diag == other.diag && super == other.super;
+        }
+    };
+
+    Key thomasKey = {-1, 0, 0, 0, 0};
+    TridiagonalLU thomasLU;
+    Key spikeKey = {-1, 0, 0, 0, 0};
+    SpikeTridiagonal spikeLU;
+};
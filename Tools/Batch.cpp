@@ -0,0 +1,392 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include "WaveEquationSolver.cpp"
+#include "Sweep.cpp"
+#include "ThreadPool.cpp"
+
+/// @struct BatchCoefficients
+/// @brief Per-lane scheme coefficients of a batch, one array per SchemeCoefficients field
+struct BatchCoefficients {
+    std::vector<double> c;
+    std::vector<double> lw_advect;
+    std::vector<double> lw_diffuse;
+    std::vector<double> i_udt;
+    std::vector<double> i_dx;
+    std::vector<double> i_denom;
+    std::vector<double> r_predict;
+    std::vector<double> r_correct;
+
+    void push_back(const SchemeCoefficients& k) {
+        c.push_back(k.c);
+        lw_advect.push_back(k.lw_advect);
+        lw_diffuse.push_back(k.lw_diffuse);
+        i_udt.push_back(k.i_udt);
+        i_dx.push_back(k.dx);
+        i_denom.push_back(k.i_denom);
+        r_predict.push_back(k.r_predict);
+        r_correct.push_back(k.r_correct);
+    }
+};
+
+/// @brief Scalar batch kernels: value (i, lane) at row[i * M + lane], lanes innermost
+namespace simd_scalar {
+inline void Batch_FTBS(const BatchCoefficients& k, const double* prev, double* next, int M, int lanes, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        const double* p = prev + static_cast<size_t>(i) * M;
+        double* n = next + static_cast<size_t>(i) * M;
+        for (int j = 0; j < lanes; j++) {
+            n[j] = p[j] - k.c[j] * (p[j] - p[j - M]);
+        }
+    }
+}
+
+inline void Batch_Lax_Wendroff(const BatchCoefficients& k, const double* prev, double* next, int M, int lanes, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        const double* p = prev + static_cast<size_t>(i) * M;
+        double* n = next + static_cast<size_t>(i) * M;
+        for (int j = 0; j < lanes; j++) {
+            n[j] = p[j] - k.lw_advect[j] * (p[j + M] - p[j - M]) + k.lw_diffuse[j] * (p[j + M] - 2 * p[j] + p[j - M]);
+        }
+    }
+}
+
+inline void Batch_I_FTBS(const BatchCoefficients& k, double* row, int M, int lanes, int begin, int end) {
+    for (int i = end - 1; i >= begin; i--) {
+        double* r = row + static_cast<size_t>(i) * M;
+        for (int j = 0; j < lanes; j++) {
+            r[j] = (k.i_udt[j] * r[j - M] + k.i_dx[j] * r[j]) / k.i_denom[j];
+        }
+    }
+}
+
+inline void Batch_Richtmyer(const BatchCoefficients& k, double* row, double* half, int M, int lanes, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        const double* p = row + static_cast<size_t>(i) * M;
+        double* predicted = half + static_cast<size_t>(i) * M;
+        for (int j = 0; j < lanes; j++) {
+            predicted[j] = 0.5 * (p[j + M] + p[j - M]) - k.r_predict[j] * (p[j + M] - p[j - M]);
+        }
+    }
+    for (int i = begin; i < end; i++) {
+        double* p = row + static_cast<size_t>(i) * M;
+        const double* predicted = half + static_cast<size_t>(i) * M;
+        for (int j = 0; j < lanes; j++) {
+            p[j] = p[j] - k.r_correct[j] * (predicted[j + M] - predicted[j - M]);
+        }
+    }
+}
+}
+
+#ifdef SIMD_KERNELS_X86
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("sse2")
+namespace simd_sse2 {
+#define SIMD_BYTES 16
+#include "BatchRowKernels.cpp"
+#undef SIMD_BYTES
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("avx2")
+namespace simd_avx2 {
+#define SIMD_BYTES 32
+#include "BatchRowKernels.cpp"
+#undef SIMD_BYTES
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("avx512f")
+namespace simd_avx512 {
+#define SIMD_BYTES 64
+#include "BatchRowKernels.cpp"
+#undef SIMD_BYTES
+}
+#pragma GCC pop_options
+#endif
+
+/// @struct BatchKernelSet
+/// @brief Batch kernels of one instruction set
+struct BatchKernelSet {
+    typedef void (*TwoRows)(const BatchCoefficients& k, const double* prev, double* next, int M, int lanes, int begin, int end);
+    typedef void (*InPlace)(const BatchCoefficients& k, double* row, int M, int lanes, int begin, int end);
+    typedef void (*WithHalf)(const BatchCoefficients& k, double* row, double* half, int M, int lanes, int begin, int end);
+
+    SimdISA isa;
+    int width;      ///< Lanes per vector; lane counts are rounded up to it
+    TwoRows ftbs;
+    TwoRows lax_wendroff;
+    InPlace implicit_ftbs;
+    WithHalf richtmyer;
+
+    /// @brief Kernel set for an instruction set, falling back to scalar when unsupported
+    static BatchKernelSet select(SimdISA isa) {
+        if (!simdSupported(isa)) isa = SimdISA::Scalar;
+        switch (isa) {
+#ifdef SIMD_KERNELS_X86
+        case SimdISA::SSE2:
+            return {isa, simd_sse2::Vec<double>::W, simd_sse2::Batch_FTBS, simd_sse2::Batch_Lax_Wendroff,
+                    simd_sse2::Batch_I_FTBS, simd_sse2::Batch_Richtmyer};
+        case SimdISA::AVX2:
+            return {isa, simd_avx2::Vec<double>::W, simd_avx2::Batch_FTBS, simd_avx2::Batch_Lax_Wendroff,
+                    simd_avx2::Batch_I_FTBS, simd_avx2::Batch_Richtmyer};
+        case SimdISA::AVX512:
+            return {isa, simd_avx512::Vec<double>::W, simd_avx512::Batch_FTBS, simd_avx512::Batch_Lax_Wendroff,
+                    simd_avx512::Batch_I_FTBS, simd_avx512::Batch_Richtmyer};
+#endif
+        default:
+            return {SimdISA::Scalar, 1, simd_scalar::Batch_FTBS, simd_scalar::Batch_Lax_Wendroff,
+                    simd_scalar::Batch_I_FTBS, simd_scalar::Batch_Richtmyer};
+        }
+    }
+};
+
+/// @class BatchSolver
+/// @brief Advances several configurations of one scheme on one grid side by side
+/// @note The configurations share the scheme, N and the domain; u, CFL, t_max and
+///       the initial set may differ per lane. Lanes are ordered by decreasing step
+///       count, so the lanes still running at a given level are a prefix and the
+///       finished ones are masked by shortening the lane loop (to whole vectors: the
+///       extra lanes have already streamed their last level). The lane count is
+///       padded to LANE_ALIGN with copies of the last lane. Each lane streams to its
+///       own sink exactly as WaveEquationSolver::solve would (same levels, same
+///       times, bit-identical values).
+class BatchSolver {
+public:
+    /// @brief Lane padding: a row of the interleaved layout is a whole number of AVX-512 vectors
+    static const int LANE_ALIGN = 8;
+
+    /// @brief Constructor
+    /// @param inputs One Input per lane (same N, x_min and x_max)
+    /// @param scheme The scheme of every lane
+    /// @param isa Instruction set of the kernels; unsupported sets fall back to scalar
+    BatchSolver(const std::vector<Input>& inputs, WaveEquationSolver::Scheme scheme, SimdISA isa = simdBest())
+        : scheme(scheme), kernels(BatchKernelSet::select(isa)) {
+        for (const Input& input : inputs) {
+            solvers.emplace_back(input);
+        }
+    }
+
+    /// @brief Whether a configuration can join a batch of another one
+    static bool compatible(const Input& a, const Input& b) {
+        return a.N == b.N && a.x_min == b.x_min && a.x_max == b.x_max;
+    }
+
+    /// @brief Number of configurations
+    int size() const { return static_cast<int>(solvers.size()); }
+
+    /// @brief Solves every lane
+    /// @param sinks One sink per lane, in the order of the inputs
+    /// @param policy Selects the recorded levels of every lane (in each lane's own dt)
+    void solve(const std::vector<RowSink*>& sinks, const RecordPolicy& policy = RecordPolicy()) {
+        if (scheme != WaveEquationSolver::E_FTBS && scheme != WaveEquationSolver::I_FTBS &&
+            scheme != WaveEquationSolver::Lax_Wendroff && scheme != WaveEquationSolver::Richtmyer_MultiStep) {
+            std::cerr << "Error: unsupported scheme " << scheme << std::endl;
+            return;
+        }
+        if (solvers.empty()) return;
+        for (const WaveEquationSolver& solver : solvers) {
+            if (!compatible(solver.input, solvers[0].input)) {
+                std::cerr << "Error: batched configurations must share N and the domain" << std::endl;
+                return;
+            }
+        }
+
+        // Lanes by decreasing step count: the running lanes are always a prefix
+        const int count = size();
+        const int M = (count + LANE_ALIGN - 1) / LANE_ALIGN * LANE_ALIGN;
+        std::vector<int> steps(count);
+        std::vector<int> order(count);
+        for (int j = 0; j < count; j++) {
+            steps[j] = solvers[j].stepCount(scheme);
+            order[j] = j;
+        }
+        std::stable_sort(order.begin(), order.end(), [&steps](int a, int b) { return steps[a] > steps[b]; });
+        order.resize(M, order.back());
+
+        const int N = solvers[0].input.N;
+        BatchCoefficients k;
+        std::vector<RecordSchedule> schedules;
+        std::vector<int> laneSteps(count);
+        for (int j = 0; j < M; j++) {
+            const WaveEquationSolver& solver = solvers[order[j]];
+            k.push_back(SchemeCoefficients::make(solver.dx, solver.dt, solver.input.u));
+            if (j < count) {
+                laneSteps[j] = steps[order[j]];
+                schedules.emplace_back(policy, solver.dt, laneSteps[j]);
+            }
+        }
+
+        // Interleaved levels; all buffers start from the initial level so points
+        // outside the update range keep their initial value
+        const size_t size = static_cast<size_t>(N) * M;
+        SimdRow<double> a(static_cast<int>(size)), b(static_cast<int>(size)), half(static_cast<int>(size));
+        // Lanes share the grid, so the initial row is evaluated once per initial condition
+        std::vector<double (*)(double)> functions;
+        std::vector<std::vector<double>> initials;
+        for (int j = 0; j < M; j++) {
+            const WaveEquationSolver& solver = solvers[order[j]];
+            size_t f = std::find(functions.begin(), functions.end(), solver.input.bondary.t0_function) - functions.begin();
+            if (f == functions.size()) {
+                functions.push_back(solver.input.bondary.t0_function);
+                initials.push_back(solver.initialRow());
+            }
+            for (int i = 0; i < N; i++) a[i * M + j] = initials[f][i];
+        }
+        std::copy(a.data(), a.data() + size, b.data());
+        std::copy(a.data(), a.data() + size, half.data());
+        std::vector<double> column(N);
+        int begin, end;
+        solvers[0].updateRange(scheme, begin, end);
+
+        for (int j = 0; j < count; j++) {
+            sinks[order[j]]->begin(solvers[order[j]].runInfo(scheme));
+        }
+        double* current = a.data();
+        double* spare = b.data();
+        int lanes = count;
+        for (int level = 0; level <= laneSteps[0]; level++) {
+            while (laneSteps[lanes - 1] < level) lanes--;
+            if (level > 0) {
+                const int vectorLanes = (lanes + kernels.width - 1) / kernels.width * kernels.width;
+                switch (scheme) {
+                case WaveEquationSolver::E_FTBS:
+                    kernels.ftbs(k, current, spare, M, vectorLanes, begin, end);
+                    std::swap(current, spare);
+                    break;
+                case WaveEquationSolver::Lax_Wendroff:
+                    kernels.lax_wendroff(k, current, spare, M, vectorLanes, begin, end);
+                    std::swap(current, spare);
+                    break;
+                case WaveEquationSolver::I_FTBS:
+                    kernels.implicit_ftbs(k, current, M, vectorLanes, begin, end);
+                    break;
+                default:
+                    kernels.richtmyer(k, current, half.data(), M, vectorLanes, begin, end);
+                    break;
+                }
+            }
+            for (int j = 0; j < lanes; j++) {
+                if (!schedules[j].at(level)) continue;
+                for (int i = 0; i < N; i++) column[i] = current[static_cast<size_t>(i) * M + j];
+                sinks[order[j]]->write(level, level * solvers[order[j]].dt, column.data(), N);
+            }
+        }
+        for (int j = 0; j < count; j++) {
+            sinks[order[j]]->end();
+        }
+    }
+
+private:
+    WaveEquationSolver::Scheme scheme;
+    BatchKernelSet kernels;
+    std::vector<WaveEquationSolver> solvers;
+};
+
+/// @class BatchRunner
+/// @brief Runs sweep jobs as batches of configurations on a thread pool
+/// @note Jobs sharing the scheme, N and the domain are grouped, sorted by step
+///       count (so lanes of a batch finish together) and cut into batches sized
+///       to keep the three interleaved rows in cache, while leaving at least one
+///       batch per thread. Outputs do not depend on the grouping.
+class BatchRunner {
+public:
+    /// @brief Constructor
+    /// @param threads Number of worker threads (0: one per hardware thread)
+    /// @param maxLanes Upper bound on the configurations of one batch
+    /// @param isa Instruction set of the batch kernels
+    BatchRunner(unsigned threads = 0, int maxLanes = 64, SimdISA isa = simdBest())
+        : threads(threads), maxLanes(std::max(1, maxLanes)), isa(isa) {}
+
+    /// @brief Bytes of the interleaved rows of one batch the lane count aims for
+    static const size_t CACHE_BYTES = 256 * 1024;
+
+    /// @brief Groups the jobs into batches
+    /// @param jobs The jobs
+    /// @return Indices into jobs, one vector per batch
+    std::vector<std::vector<size_t>> batches(const std::vector<SweepJob>& jobs) const {
+        std::vector<std::vector<size_t>> groups;
+        for (size_t i = 0; i < jobs.size(); i++) {
+            bool placed = false;
+            for (std::vector<size_t>& group : groups) {
+                const SweepJob& first = jobs[group[0]];
+                if (first.scheme == jobs[i].scheme && BatchSolver::compatible(first.input, jobs[i].input)) {
+                    group.push_back(i);
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed) groups.push_back({i});
+        }
+
+        size_t total = jobs.size();
+        unsigned workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::vector<size_t>> result;
+        for (std::vector<size_t>& group : groups) {
+            std::vector<int> steps(jobs.size());
+            for (size_t i : group) steps[i] = WaveEquationSolver(jobs[i].input).stepCount(jobs[i].scheme);
+            std::stable_sort(group.begin(), group.end(), [&steps](size_t a, size_t b) { return steps[a] > steps[b]; });
+
+            const size_t N = static_cast<size_t>(jobs[group[0]].input.N);
+            size_t lanes = std::max<size_t>(8, CACHE_BYTES / (3 * sizeof(double) * std::max<size_t>(N, 1)));
+            // Share of the threads proportional to the group size
+            size_t share = std::max<size_t>(1, workers * group.size() / std::max<size_t>(total, 1));
+            lanes = std::min(lanes, (group.size() + share - 1) / share);
+            lanes = std::max<size_t>(1, std::min(lanes, static_cast<size_t>(maxLanes)));
+            for (size_t start = 0; start < group.size(); start += lanes) {
+                result.emplace_back(group.begin() + start, group.begin() + std::min(group.size(), start + lanes));
+            }
+        }
+        return result;
+    }
+
+    /// @brief Runs every job
+    /// @param jobs The jobs; their `seconds` field receives the wall time of their batch divided by its size
+    /// @param sinks One sink per job, indexed like jobs (each is only used by one thread)
+    /// @param policy Selects the recorded levels
+    void run(std::vector<SweepJob>& jobs, const std::vector<RowSink*>& sinks, const RecordPolicy& policy = RecordPolicy()) {
+        std::vector<std::vector<size_t>> groups = batches(jobs);
+        std::vector<double> cost(groups.size());
+        std::vector<size_t> order(groups.size());
+        for (size_t g = 0; g < groups.size(); g++) {
+            const SweepJob& job = jobs[groups[g][0]];
+            cost[g] = static_cast<double>(job.input.N) * groups[g].size() * WaveEquationSolver(job.input).stepCount(job.scheme);
+            order[g] = g;
+        }
+        std::stable_sort(order.begin(), order.end(), [&cost](size_t a, size_t b) { return cost[a] > cost[b]; });
+
+        ThreadPool pool(threads);
+        for (size_t g : order) {
+            const std::vector<size_t>* group = &groups[g];
+            pool.submit([&, group]() {
+                auto start = std::chrono::steady_clock::now();
+                std::vector<Input> inputs;
+                std::vector<RowSink*> laneSinks;
+                for (size_t i : *group) {
+                    inputs.push_back(jobs[i].input);
+                    laneSinks.push_back(sinks[i]);
+                }
+                BatchSolver solver(inputs, jobs[(*group)[0]].scheme, isa);
+                solver.solve(laneSinks, policy);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                for (size_t i : *group) jobs[i].seconds = elapsed.count() / group->size();
+            });
+        }
+        pool.wait();
+    }
+
+private:
+    unsigned threads;
+    int maxLanes;
+    SimdISA isa;
+};
@@ -0,0 +1,81 @@
+// Vector kernels of the interleaved batch layout, included once per instruction set
+// by Batch.cpp inside the simd_* namespaces of SimdKernels.cpp (reusing their Vec).
+// Value (i, lane) lives at row[i * M + lane]. Each vector of lanes walks down the
+// points with its coefficients in registers and the neighbours carried from the
+// previous point, so a point costs one load and one store whatever the stencil.
+// The caller rounds `lanes` up to the vector width. Every lane performs the same
+// operations in the same order as Row_Schemes.
+
+inline void Batch_FTBS(const BatchCoefficients& k, const double* prev, double* next, int M, int lanes, int begin, int end) {
+    typedef Vec<double> V;
+    for (int j = 0; j < lanes; j += V::W) {
+        const V::type c = V::load(k.c.data() + j);
+        V::type left = V::load(prev + static_cast<size_t>(begin - 1) * M + j);
+        for (int i = begin; i < end; i++) {
+            V::type here = V::load(prev + static_cast<size_t>(i) * M + j);
+            V::store(next + static_cast<size_t>(i) * M + j, here - c * (here - left));
+            left = here;
+        }
+    }
+}
+
+inline void Batch_Lax_Wendroff(const BatchCoefficients& k, const double* prev, double* next, int M, int lanes, int begin, int end) {
+    typedef Vec<double> V;
+    const V::type two = V::splat(2);
+    for (int j = 0; j < lanes; j += V::W) {
+        const V::type a = V::load(k.lw_advect.data() + j);
+        const V::type b = V::load(k.lw_diffuse.data() + j);
+        V::type left = V::load(prev + static_cast<size_t>(begin - 1) * M + j);
+        V::type here = V::load(prev + static_cast<size_t>(begin) * M + j);
+        for (int i = begin; i < end; i++) {
+            V::type right = V::load(prev + static_cast<size_t>(i + 1) * M + j);
+            V::store(next + static_cast<size_t>(i) * M + j, here - a * (right - left) + b * (right - two * here + left));
+            left = here;
+            here = right;
+        }
+    }
+}
+
+// The descending sweep is sequential in i but independent across lanes: each
+// vector carries one division per lane instead of one dependent division per point
+inline void Batch_I_FTBS(const BatchCoefficients& k, double* row, int M, int lanes, int begin, int end) {
+    typedef Vec<double> V;
+    for (int j = 0; j < lanes; j += V::W) {
+        const V::type udt = V::load(k.i_udt.data() + j);
+        const V::type dx = V::load(k.i_dx.data() + j);
+        const V::type denom = V::load(k.i_denom.data() + j);
+        if (end <= begin) continue;
+        V::type here = V::load(row + static_cast<size_t>(end - 1) * M + j);
+        for (int i = end - 1; i >= begin; i--) {
+            V::type left = V::load(row + static_cast<size_t>(i - 1) * M + j);
+            V::store(row + static_cast<size_t>(i) * M + j, (udt * left + dx * here) / denom);
+            here = left;
+        }
+    }
+}
+
+inline void Batch_Richtmyer(const BatchCoefficients& k, double* row, double* half, int M, int lanes, int begin, int end) {
+    typedef Vec<double> V;
+    const V::type h = V::splat(0.5);
+    for (int j = 0; j < lanes; j += V::W) {
+        const V::type predict = V::load(k.r_predict.data() + j);
+        const V::type correct = V::load(k.r_correct.data() + j);
+        V::type left = V::load(row + static_cast<size_t>(begin - 1) * M + j);
+        V::type here = V::load(row + static_cast<size_t>(begin) * M + j);
+        for (int i = begin; i < end; i++) {
+            V::type right = V::load(row + static_cast<size_t>(i + 1) * M + j);
+            V::store(half + static_cast<size_t>(i) * M + j, h * (right + left) - predict * (right - left));
+            left = here;
+            here = right;
+        }
+        V::type hl = V::load(half + static_cast<size_t>(begin - 1) * M + j);
+        V::type hm = V::load(half + static_cast<size_t>(begin) * M + j);
+        for (int i = begin; i < end; i++) {
+            V::type hr = V::load(half + static_cast<size_t>(i + 1) * M + j);
+            V::type p = V::load(row + static_cast<size_t>(i) * M + j);
+            V::store(row + static_cast<size_t>(i) * M + j, p - correct * (hr - hl));
+            hl = hm;
+            hm = hr;
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+
+#include "MappedFile.cpp"
+
+/// @struct CSVIssue
+/// @brief A malformed row found while reading a CSV file
+struct CSVIssue {
+    size_t line;         ///< 1-based line number in the file
+    std::string message; ///< What went wrong
+};
+
+/// @class CSVColumnReader
+/// @brief Zero-copy reader extracting one numeric column of a memory-mapped CSV file
+/// @note Values are parsed in place with std::from_chars as double (the precision the
+///       solver writes) and converted to T. Large files are split at
+///       line boundaries and parsed concurrently; malformed rows are skipped and
+///       reported with their line number instead of aborting the read.
+class CSVColumnReader {
+public:
+    /// @brief Maximum number of issues kept (later ones are only counted)
+    static const size_t MAX_ISSUES = 100;
+
+    /// @brief Constructor
+    /// @param threads Number of parsing threads (0: one per hardware thread)
+    CSVColumnReader(unsigned threads = 0) : threads(threads) {}
+
+    /// @brief Reads a column selected by its header name
+    /// @param filename The CSV file (first line is the header)
+    /// @param column Column name; surrounding spaces in the header are ignored
+    /// @param values Receives the parsed values (appended)
+    /// @return False if the file or the column cannot be found
+    template <class T>
+    bool read(const std::string& filename, const std::string& column, std::vector<T>& values) {
+        MappedFile file;
+        if (!file.open(filename)) {
+            return false;
+        }
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        const char* headerEnd = lineEnd(begin, end);
+
+        int index = columnIndex(begin, headerEnd, column);
+        if (index < 0) {
+            std::cerr << "Error: no column '" << column << "' in " << filename << std::endl;
+            return false;
+        }
+        parse(headerEnd == end ? end : headerEnd + 1, end, index, 2, values);
+        return true;
+    }
+
+    /// @brief Reads a column selected by its 0-based index
+    /// @param filename The CSV file (first line is the header)
+    /// @param column Column index
+    /// @param values Receives the parsed values (appended)
+    /// @return False if the file cannot be opened
+    template <class T>
+    bool read(const std::string& filename, int column, std::vector<T>& values) {
+        MappedFile file;
+        if (!file.open(filename)) {
+            return false;
+        }
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        const char* headerEnd = lineEnd(begin, end);
+        parse(headerEnd == end ? end : headerEnd + 1, end, column, 2, values);
+        return true;
+    }
+
+    /// @brief Malformed rows of the last read (at most MAX_ISSUES)
+    const std::vector<CSVIssue>& getIssues() const { return issues; }
+
+    /// @brief Number of malformed rows of the last read
+    size_t issueCount() const { return totalIssues; }
+
+    /// @brief Number of lines after the header in the last read
+    size_t rowCount() const { return rows; }
+
+private:
+    /// @brief Result of parsing one chunk of lines
+    template <class T>
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        std::vector<T> values;
+        std::vector<CSVIssue> issues; ///< Line numbers relative to the chunk
+        size_t issueCount = 0;
+        size_t lines = 0;
+    };
+
+    static const char* lineEnd(const char* p, const char* end) {
+        const void* found = std::memchr(p, '\n', end - p);
+        return found ? static_cast<const char*>(found) : end;
+    }
+
+    static const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        return p;
+    }
+
+    static int columnIndex(const char* p, const char* end, const std::string& column) {
+        int index = 0;
+        while (p <= end) {
+            const void* comma = std::memchr(p, ',', end - p);
+            const char* fieldEnd = comma ? static_cast<const char*>(comma) : end;
+            const char* first = skipSpaces(p, fieldEnd);
+            const char* last = fieldEnd;
+            while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) last--;
+            if (std::string(first, last) == column) {
+                return index;
+            }
+            if (!comma) break;
+            p = fieldEnd + 1;
+            index++;
+        }
+        return -1;
+    }
+
+    template <class T>
+    static void parseChunk(Chunk<T>& chunk, int column) {
+        // Bulk growth: estimate the row count from the chunk size
+        chunk.values.reserve((chunk.end - chunk.begin) / 16 + 1);
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* eol = lineEnd(p, chunk.end);
+            chunk.lines++;
+            const char* field = p;
+            for (int c = 0; c < column && field; c++) {
+                const void* comma = std::memchr(field, ',', eol - field);
+                field = comma ? static_cast<const char*>(comma) + 1 : nullptr;
+            }
+            const char* last = eol;
+            while (last > p && (last[-1] == '\r' || last[-1] == ' ')) last--;
+            if (last == p) {
+                // Blank line: ignored
+                p = eol + 1;
+                continue;
+            }
+
+            const char* message = nullptr;
+            double value;
+            if (!field) {
+                message = "missing column";
+            } else {
+                const char* first = skipSpaces(field, last);
+                if (first < last && *first == '+') first++;
+                std::from_chars_result result = std::from_chars(first, last, value);
+                if (result.ec != std::errc()) {
+                    message = "not a number";
+                } else if (skipSpaces(result.ptr, last) != last && *skipSpaces(result.ptr, last) != ',') {
+                    message = "trailing characters after number";
+                }
+            }
+            if (message) {
+                if (chunk.issues.size() < MAX_ISSUES) {
+                    chunk.issues.push_back({chunk.lines, message});
+                }
+                chunk.issueCount++;
+            } else {
+                chunk.values.push_back(static_cast<T>(value));
+            }
+            p = eol + 1;
+        }
+    }
+
+    template <class T>
+    void parse(const char* begin, const char* end, int column, size_t firstLine, std::vector<T>& values) {
+        issues.clear();
+        totalIssues = 0;
+        rows = 0;
+
+        // Split at line boundaries into chunks of at least 4 MiB
+        unsigned count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        const size_t minChunk = 4 << 20;
+        size_t size = end - begin;
+        count = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(count, size / minChunk)));
+
+        std::vector<Chunk<T>> chunks(count);
+        const char* p = begin;
+        for (unsigned c = 0; c < count; c++) {
+            const char* stop = (c + 1 == count) ? end : std::min(end, begin + size * (c + 1) / count);
+            if (stop < end && stop > p) stop = std::min(end, lineEnd(stop - 1, end) + 1);
+            chunks[c].begin = p;
+            chunks[c].end = std::max(p, stop);
+            p = chunks[c].end;
+        }
+
+        if (count == 1) {
+            parseChunk(chunks[0], column);
+        } else {
+            std::vector<std::thread> workers;
+            for (unsigned c = 0; c < count; c++) {
+                workers.emplace_back([&chunks, c, column]() { parseChunk(chunks[c], column); });
+            }
+            for (std::thread& worker : workers) worker.join();
+        }
+
+        size_t total = values.size();
+        for (const Chunk<T>& chunk : chunks) total += chunk.values.size();
+        values.reserve(total);
+        size_t line = firstLine - 1;
+        for (const Chunk<T>& chunk : chunks) {
+            values.insert(values.end(), chunk.values.begin(), chunk.values.end());
+            for (const CSVIssue& issue : chunk.issues) {
+                if (issues.size() < MAX_ISSUES) {
+                    issues.push_back({issue.line + line, issue.message});
+                }
+            }
+            totalIssues += chunk.issueCount;
+            line += chunk.lines;
+            rows += chunk.lines;
+        }
+    }
+
+    unsigned threads;
+    std::vector<CSVIssue> issues;
+    size_t totalIssues = 0;
+    size_t rows = 0;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+
+#include "Profiler.cpp"
+
+/// @class CSVWriter
+/// @brief Buffered, locale-free writer for `x, t, f` result files
+/// @note Numbers are formatted with std::to_chars into a large reusable buffer
+///       that is written in big chunks. With the default precision of 6 the
+///       output is byte-identical to `std::ofstream << double`.
+class CSVWriter {
+public:
+    /// @brief Precision value selecting the shortest round-trip representation
+    static const int SHORTEST = -1;
+
+    /// @brief Constructor
+    /// @param precision Significant digits (as with `%g`, clamped to 1..17), or SHORTEST
+    /// @param bufferSize Size of the output buffer in bytes
+    CSVWriter(int precision = 6, size_t bufferSize = 1 << 20)
+        : precision(precision == SHORTEST ? SHORTEST : std::max(1, std::min(precision, 17))), buffer(std::max<size_t>(bufferSize, 4096)) {}
+
+    ~CSVWriter() { close(); }
+
+    /// @brief Opens the output file and writes the header line
+    /// @param filename The output file
+    /// @return True on success
+    bool open(const std::string& filename) {
+        out.open(filename, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return false;
+        }
+        used = 0;
+        append("x, t, f\n", 8);
+        return true;
+    }
+
+    /// @brief Precomputes the formatted x column ("x, " for every point)
+    /// @param x_min x of the first point
+    /// @param dx Spatial step size
+    /// @param n Number of points per row
+    void setColumns(double x_min, double dx, int n) {
+        xText.clear();
+        xOffsets.assign(1, 0);
+        char number[64];
+        for (int j = 0; j < n; j++) {
+            double x = x_min + j * dx;
+            char* end = format(number, number + sizeof(number), x);
+            xText.append(number, end);
+            xText.append(", ");
+            xOffsets.push_back(xText.size());
+        }
+    }
+
+    /// @brief Appends one time level: a line per point
+    /// @param t Time of the level
+    /// @param row The values
+    /// @param n Number of values (rows of another length are refused)
+    void writeRow(double t, const double* row, int n) {
+        if (!out.is_open()) return;
+        if (static_cast<size_t>(n) + 1 != xOffsets.size()) {
+            std::cerr << "Error: row of " << n << " values for " << columns() << " CSV columns" << std::endl;
+            return;
+        }
+        PROFILE_SCOPE("csv_format");
+        char tText[64];
+        char* tEnd = format(tText, tText + sizeof(tText), t);
+        tEnd[0] = ',';
+        tEnd[1] = ' ';
+        const size_t tLength = tEnd + 2 - tText;
+
+        for (int j = 0; j < n; j++) {
+            // Longest line: x and t texts plus at most 32 chars of value and newline
+            const size_t xLength = xOffsets[j + 1] - xOffsets[j];
+            if (used + xLength + tLength + 32 > buffer.size()) {
+                flush();
+            }
+            char* p = buffer.data() + used;
+            std::memcpy(p, xText.data() + xOffsets[j], xLength);
+            p += xLength;
+            std::memcpy(p, tText, tLength);
+            p += tLength;
+            p = format(p, p + 32, row[j]);
+            *p++ = '\n';
+            used = p - buffer.data();
+        }
+    }
+
+    /// @brief Number of points per row set by setColumns
+    int columns() const { return xOffsets.empty() ? 0 : static_cast<int>(xOffsets.size()) - 1; }
+
+    /// @brief Writes the buffered bytes to the file
+    void flush() {
+        if (used > 0 && out.is_open()) {
+            PROFILE_SCOPE("file_write");
+            PROFILE_COUNT("bytes_written", used);
+            out.write(buffer.data(), used);
+        }
+        bytes += used;
+        used = 0;
+    }
+
+    /// @brief Flushes and closes the file
+    void close() {
+        if (out.is_open()) {
+            flush();
+            out.close();
+        }
+    }
+
+    /// @brief Total number of bytes written so far
+    size_t bytesWritten() const { return bytes + used; }
+
+private:
+    char* format(char* first, char* last, double value) const {
+        std::to_chars_result result = (precision == SHORTEST)
+            ? std::to_chars(first, last, value)
+            : std::to_chars(first, last, value, std::chars_format::general, precision);
+        return result.ptr;
+    }
+
+    void append(const char* text, size_t length) {
+        if (used + length > buffer.size()) flush();
+        std::memcpy(buffer.data() + used, text, length);
+        used += length;
+    }
+
+    int precision;
+    std::vector<char> buffer;
+    size_t used = 0;
+    size_t bytes = 0;
+    std::ofstream out;
+    std::string xText;
+    std::vector<size_t> xOffsets;
+};
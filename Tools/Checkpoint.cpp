@@ -0,0 +1,258 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#ifndef _WIN32
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap
+#include <unistd.h>   // For ftruncate, close
+#endif
+
+#include "Output.cpp"
+#include "MappedFile.cpp"
+#include "Profiler.cpp"
+
+/// @struct CheckpointHeader
+/// @brief Fixed 256-byte header of a checkpoint file (.wck, little-endian)
+/// @note Layout: header | N float64 values of the live row at `level`. The run
+///       fields identify the solve the checkpoint belongs to; a solve only
+///       resumes from a checkpoint whose fields all match its own.
+struct CheckpointHeader {
+    char magic[8];          ///< "WESCKP1" followed by a NUL
+    uint32_t version;       ///< Format version (1)
+    uint32_t value_size;    ///< 8 (float64 values)
+    char scheme[32];        ///< Scheme name, NUL padded
+    char bondary[32];       ///< Boundary set name, NUL padded
+    double u;               ///< Input: advection velocity
+    double L;               ///< Input: domain length
+    double x_min;           ///< Input: minimum x
+    double x_max;           ///< Input: maximum x
+    int64_t t_max;          ///< Input: final time
+    int64_t N;              ///< Input: values per row
+    double CFL;             ///< Input: Courant-Friedrichs-Lewy number
+    double dt;              ///< Time step size
+    double dx;              ///< Spatial step size
+    int64_t steps;          ///< Steps of the whole run
+    int64_t level;          ///< Level of the stored row
+    int64_t data_offset;    ///< Byte offset of the row
+    char reserved[80];      ///< Zero
+};
+static_assert(sizeof(CheckpointHeader) == 256, "CheckpointHeader must stay 256 bytes");
+
+/// @brief Magic string identifying checkpoint files
+static const char CHECKPOINT_MAGIC[8] = {'W', 'E', 'S', 'C', 'K', 'P', '1', '\0'};
+
+/// @brief Whether two headers describe the same run (the level is not compared)
+inline bool sameRun(const CheckpointHeader& a, const CheckpointHeader& b) {
+    return std::strncmp(a.scheme, b.scheme, sizeof(a.scheme)) == 0 && std::strncmp(a.bondary, b.bondary, sizeof(a.bondary)) == 0 &&
+           a.u == b.u && a.L == b.L && a.x_min == b.x_min && a.x_max == b.x_max && a.t_max == b.t_max && a.N == b.N &&
+           a.CFL == b.CFL && a.dt == b.dt && a.dx == b.dx && a.steps == b.steps;
+}
+
+/// @brief Reads a checkpoint file
+/// @param filename The checkpoint
+/// @param header Receives the header
+/// @param row Receives the N values of the stored level
+/// @return False if the file is missing, truncated or not a checkpoint
+inline bool readCheckpoint(const std::string& filename, CheckpointHeader& header, std::vector<double>& row) {
+    std::ifstream probe(filename, std::ios::binary);
+    if (!probe.is_open()) return false;
+    probe.close();
+    MappedFile file;
+    if (!file.open(filename) || file.size() < sizeof(CheckpointHeader)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || header.version != 1 ||
+        header.value_size != 8 || header.N < 0 || header.data_offset < static_cast<int64_t>(sizeof(CheckpointHeader)) ||
+        file.size() < static_cast<size_t>(header.data_offset) + static_cast<size_t>(header.N) * sizeof(double)) {
+        std::cerr << "Error reading file: " << filename << std::endl;
+        return false;
+    }
+    row.resize(static_cast<size_t>(header.N));
+    std::memcpy(row.data(), file.data() + header.data_offset, row.size() * sizeof(double));
+    return true;
+}
+
+/// @class CheckpointWriter
+/// @brief Writes checkpoints on a background thread
+/// @note `submit` copies the row into a pending buffer and returns; the thread
+///       maps a temporary file next to the checkpoint, fills it, syncs it and
+///       renames it over the previous checkpoint, so the file on disk is always
+///       a complete checkpoint. When a checkpoint is submitted before the
+///       previous one reached the disk, the older pending one is dropped: the
+///       stepping loop never waits for the disk.
+class CheckpointWriter {
+public:
+    /// @brief Starts the writer thread
+    /// @param filename The checkpoint file
+    CheckpointWriter(const std::string& filename) : filename(filename) {
+        worker = std::thread([this]() { work(); });
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /// @brief Writes the pending checkpoint and stops the thread
+    ~CheckpointWriter() {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    /// @brief Queues a checkpoint
+    /// @param header The header (level included)
+    /// @param row The live row
+    /// @param n Number of values
+    void submit(const CheckpointHeader& header, const double* row, int n) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (hasPending) dropped++;
+            pendingHeader = header;
+            pending.assign(row, row + n);
+            hasPending = true;
+        }
+        wake.notify_one();
+    }
+
+    /// @brief Blocks until the last submitted checkpoint is on disk
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return !hasPending && !writing; });
+    }
+
+    int written = 0; ///< Checkpoints renamed into place (read after flush)
+    int dropped = 0; ///< Checkpoints replaced by a newer one before being written
+    int failed = 0;  ///< Checkpoints that could not be written
+
+private:
+    void work() {
+        std::vector<double> row;
+        CheckpointHeader header;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return stopping || hasPending; });
+                if (!hasPending) return;
+                header = pendingHeader;
+                row.swap(pending);
+                hasPending = false;
+                writing = true;
+            }
+            const bool ok = store(header, row);
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+            if (ok) written++;
+            else failed++;
+            done.notify_all();
+        }
+    }
+
+    /// @brief Writes a checkpoint to `filename.tmp` and renames it into place
+    bool store(CheckpointHeader header, const std::vector<double>& row) {
+        PROFILE_SCOPE("checkpoint_write");
+        PROFILE_COUNT("bytes_written", sizeof(CheckpointHeader) + row.size() * sizeof(double));
+        const std::string temporary = filename + ".tmp";
+        header.data_offset = sizeof(CheckpointHeader);
+        const size_t bytes = sizeof(CheckpointHeader) + row.size() * sizeof(double);
+#ifdef _WIN32
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "Error opening file: " << temporary << std::endl;
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(double));
+            if (!out) {
+                std::cerr << "Error writing file: " << temporary << std::endl;
+                return false;
+            }
+        }
+        std::remove(filename.c_str()); // rename does not replace an existing file on Windows
+#else
+        int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Error opening file: " << temporary << std::endl;
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            ::close(fd);
+            std::cerr << "Error writing file: " << temporary << std::endl;
+            return false;
+        }
+        void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            std::cerr << "Error mapping file: " << temporary << std::endl;
+            return false;
+        }
+        std::memcpy(mapped, &header, sizeof(header));
+        std::memcpy(static_cast<char*>(mapped) + sizeof(header), row.data(), row.size() * sizeof(double));
+        const bool synced = (msync(mapped, bytes, MS_SYNC) == 0);
+        munmap(mapped, bytes);
+        ::close(fd);
+        if (!synced) {
+            std::cerr << "Error writing file: " << temporary << std::endl;
+            return false;
+        }
+#endif
+        if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+            std::cerr << "Error renaming file: " << temporary << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string filename;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    CheckpointHeader pendingHeader;
+    std::vector<double> pending;
+    bool hasPending = false;
+    bool writing = false;
+    bool stopping = false;
+};
+
+/// @class CheckpointSink
+/// @brief Sits between a stepping loop and the caller's sink
+/// @note The loop's schedule also stops at every `every`-th level; those levels
+///       are handed to the writer, and only the levels of the caller's schedule
+///       after `first` (the level the solve started from) reach the caller's sink.
+///       begin/end are the solver's job and are not forwarded.
+class CheckpointSink : public RowSink {
+public:
+    CheckpointSink(RowSink& sink, const RecordSchedule& recorded, CheckpointWriter& writer, const CheckpointHeader& run,
+                   int every, int first)
+        : sink(sink), recorded(recorded), writer(writer), header(run), every(every), first(first) {}
+
+    void write(int level, double t, const double* row, int n) override {
+        if (level > first && level % every == 0) {
+            header.level = level;
+            writer.submit(header, row, n);
+        }
+        if ((level > first || first == 0) && recorded.at(level)) {
+            sink.write(level, t, row, n);
+        }
+    }
+
+private:
+    RowSink& sink;
+    const RecordSchedule& recorded;
+    CheckpointWriter& writer;
+    CheckpointHeader header;
+    int every;
+    int first;
+};
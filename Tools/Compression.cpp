@@ -0,0 +1,557 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Output.cpp"
+#include "MappedFile.cpp"
+#include "Profiler.cpp"
+
+/// @struct CompressedHeader
+/// @brief Fixed 256-byte header of a compressed result file (.wez, little-endian)
+/// @note Layout: header | blocks | blocks x (int64 offset, int64 bytes) index |
+///       rows x (int64 level, float64 t) table. Block b holds the levels
+///       [b * block_rows, (b + 1) * block_rows) and decodes on its own, so one
+///       level is read by decoding at most block_rows rows of one block.
+struct CompressedHeader {
+    char magic[8];          ///< "WESZIP1" followed by a NUL
+    uint32_t version;       ///< Format version (1)
+    uint32_t mode;          ///< 0: lossless, 1: error-bounded
+    char scheme[32];        ///< Scheme name, NUL padded
+    char bondary[32];       ///< Boundary set name, NUL padded
+    int64_t N;              ///< Values per row
+    int64_t rows;           ///< Number of stored time levels
+    double dt;              ///< Time step size
+    double dx;              ///< Spatial step size
+    double x_min;           ///< x of the first value in a row
+    double CFL;             ///< Courant-Friedrichs-Lewy number
+    double u;               ///< Advection velocity
+    double tolerance;       ///< Absolute error bound of every value (0 when lossless)
+    int64_t block_rows;     ///< Levels per block
+    int64_t blocks;         ///< Number of blocks
+    int64_t index_offset;   ///< Byte offset of the block index
+    int64_t table_offset;   ///< Byte offset of the (level, t) table
+    char reserved[80];      ///< Zero
+};
+static_assert(sizeof(CompressedHeader) == 256, "CompressedHeader must stay 256 bytes");
+
+/// @brief Magic string identifying compressed result files
+static const char COMPRESSED_MAGIC[8] = {'W', 'E', 'S', 'Z', 'I', 'P', '1', '\0'};
+
+/// @class FieldCodec
+/// @brief Encodes and decodes the rows of a compressed result file
+/// @note Each value becomes a 64-bit symbol: its bit pattern (lossless) or the
+///       integer q = round(f / (2 * tolerance)) of its quantisation, decoded as
+///       q * 2 * tolerance (error-bounded). The symbol is predicted by the same
+///       column of the previous level, or by the previous column in the first
+///       row of a block; the residual is symbol XOR prediction (lossless) or the
+///       zigzagged difference (error-bounded). A row is stored as
+///         - a bitmap of the non-zero residuals, one bit per value (LSB first),
+///         - one 4-bit code per non-zero residual, two per byte (low nibble
+///           first): c < 8 means the c + 1 low bytes of the residual follow,
+///           8 is an escape followed by the 8 bytes of the raw double,
+///         - the residual bytes, little-endian.
+///       Smooth levels leave mostly zero or short residuals, so a constant region
+///       costs one bit per value. Values that cannot be quantised within the
+///       tolerance (non-finite or beyond 2^53 steps) are escaped and stored exactly;
+///       their symbol is 0 for the predictions that follow.
+class FieldCodec {
+public:
+    /// @brief Constructor
+    /// @param tolerance Absolute error bound (0: lossless)
+    FieldCodec(double tolerance = 0) : tolerance(tolerance > 0 ? tolerance : 0), step(2 * this->tolerance) {}
+
+    bool lossless() const { return tolerance == 0; }
+
+    /// @brief Appends an encoded row
+    /// @param row The n values
+    /// @param key First row of a block (predicted along the row)
+    /// @param state Symbols of the previous row, updated to this row's
+    /// @param out Receives the bytes
+    void encode(const double* row, int n, bool key, uint64_t* state, std::vector<uint8_t>& out) {
+        codes.resize(n);
+        residuals.resize(n);
+        const size_t mapBytes = (n + 7) / 8;
+        const size_t start = out.size();
+        out.resize(start + mapBytes + (n + 1) / 2 + 8 * static_cast<size_t>(n) + 8, 0);
+        uint8_t* map = out.data() + start;
+        size_t k = 0;
+        uint64_t previous = 0;
+        for (int j = 0; j < n; j++) {
+            const double value = row[j];
+            uint64_t symbol;
+            bool escape = false;
+            if (lossless()) {
+                std::memcpy(&symbol, &value, sizeof(symbol));
+            } else {
+                const double scaled = value / step;
+                const double limit = 9007199254740992.0; // 2^53: every q is exact as a double
+                if (std::fabs(scaled) < limit) {
+                    const int64_t q = std::llround(scaled);
+                    const double error = std::fabs(value - static_cast<double>(q) * step);
+                    escape = !(error <= tolerance);
+                    if (!escape) maxError = std::max(maxError, error);
+                    symbol = static_cast<uint64_t>(q);
+                } else {
+                    escape = true;
+                }
+                if (escape) {
+                    symbol = 0;
+                    escapes++;
+                }
+            }
+            const uint64_t predicted = key ? previous : state[j];
+            uint64_t residual;
+            if (escape) {
+                std::memcpy(&residual, &value, sizeof(residual));
+            } else if (lossless()) {
+                residual = symbol ^ predicted;
+            } else {
+                const int64_t delta = static_cast<int64_t>(symbol - predicted);
+                residual = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+            }
+            state[j] = symbol;
+            previous = symbol;
+            if (escape || residual != 0) {
+                map[j / 8] |= static_cast<uint8_t>(1u << (j % 8));
+                codes[k] = static_cast<uint8_t>(escape ? 8 : byteCount(residual) - 1);
+                residuals[k] = residual;
+                k++;
+            }
+        }
+        uint8_t* cursor = map + mapBytes;
+        for (size_t c = 0; c < k; c += 2) {
+            *cursor++ = static_cast<uint8_t>(codes[c] | (c + 1 < k ? codes[c + 1] << 4 : 0));
+        }
+        for (size_t c = 0; c < k; c++) {
+            // All 8 bytes are stored and the cursor keeps the significant ones (the buffer has 8 bytes of slack)
+            for (int b = 0; b < 8; b++) cursor[b] = static_cast<uint8_t>(residuals[c] >> (8 * b));
+            cursor += codes[c] == 8 ? 8 : codes[c] + 1;
+        }
+        out.resize(cursor - out.data());
+    }
+
+    /// @brief Decodes one row
+    /// @param in First byte of the row
+    /// @param end End of the block
+    /// @param n Number of values
+    /// @param key First row of a block
+    /// @param state Symbols of the previous row, updated to this row's
+    /// @param row Receives the n values
+    /// @return The first byte after the row, nullptr if the row is corrupted
+    const uint8_t* decode(const uint8_t* in, const uint8_t* end, int n, bool key, uint64_t* state, double* row) const {
+        const size_t mapBytes = (n + 7) / 8;
+        if (static_cast<size_t>(end - in) < mapBytes) return nullptr;
+        const uint8_t* map = in;
+        size_t k = 0;
+        for (int j = 0; j < n; j++) k += (map[j / 8] >> (j % 8)) & 1;
+        const uint8_t* nibbles = map + mapBytes;
+        const uint8_t* payload = nibbles + (k + 1) / 2;
+        if (payload > end) return nullptr;
+
+        uint64_t previous = 0;
+        size_t c = 0;
+        for (int j = 0; j < n; j++) {
+            const uint64_t predicted = key ? previous : state[j];
+            uint64_t symbol = predicted;
+            if ((map[j / 8] >> (j % 8)) & 1) {
+                const int code = (nibbles[c / 2] >> (4 * (c % 2))) & 15;
+                c++;
+                if (code > 8) return nullptr;
+                const int bytes = code == 8 ? 8 : code + 1;
+                if (end - payload < bytes) return nullptr;
+                uint64_t residual = 0;
+                if (end - payload >= 8) {
+                    std::memcpy(&residual, payload, sizeof(residual));
+                    if (bytes < 8) residual &= (uint64_t(1) << (8 * bytes)) - 1;
+                } else {
+                    for (int b = 0; b < bytes; b++) residual |= static_cast<uint64_t>(payload[b]) << (8 * b);
+                }
+                payload += bytes;
+                if (code == 8) {
+                    std::memcpy(&row[j], &residual, sizeof(double));
+                    state[j] = previous = 0;
+                    continue;
+                }
+                if (lossless()) {
+                    symbol = predicted ^ residual;
+                } else {
+                    const int64_t delta = static_cast<int64_t>(residual >> 1) ^ -static_cast<int64_t>(residual & 1);
+                    symbol = predicted + static_cast<uint64_t>(delta);
+                }
+            }
+            if (lossless()) {
+                std::memcpy(&row[j], &symbol, sizeof(double));
+            } else {
+                row[j] = static_cast<double>(static_cast<int64_t>(symbol)) * step;
+            }
+            state[j] = previous = symbol;
+        }
+        return payload;
+    }
+
+    double maxError = 0;    ///< Largest |f - decoded f| of the encoded values (escapes are exact)
+    long long escapes = 0;  ///< Values stored raw because they could not be quantised
+
+private:
+    /// @brief Number of low bytes holding the set bits of a non-zero value
+    static int byteCount(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return (64 - __builtin_clzll(value) + 7) / 8;
+#else
+        int bytes = 1;
+        while (bytes < 8 && (value >> (8 * bytes)) != 0) bytes++;
+        return bytes;
+#endif
+    }
+
+    double tolerance;
+    double step;
+    std::vector<uint8_t> codes;
+    std::vector<uint64_t> residuals;
+};
+
+/// @struct CompressionMetrics
+/// @brief Counters of a CompressedSink run (read after `end`)
+struct CompressionMetrics {
+    long long rows = 0;            ///< Levels written
+    long long blocks = 0;          ///< Blocks written
+    long long rawBytes = 0;        ///< Size of the values as float64
+    long long fileBytes = 0;       ///< Size of the compressed file, header and tables included
+    double maxError = 0;           ///< Largest absolute error of a stored value (0 when lossless)
+    long long escapes = 0;         ///< Values stored exactly because they could not be quantised
+    double compressSeconds = 0;    ///< Time the compression thread spent encoding and writing
+
+    /// @brief rawBytes / fileBytes
+    double ratio() const { return fileBytes > 0 ? static_cast<double>(rawBytes) / fileBytes : 0; }
+};
+
+/// @class CompressedSink
+/// @brief Streams levels to a compressed result file
+/// @note Levels are gathered into blocks of `blockRows` rows; each full block
+///       goes to a compression thread that encodes and writes it while the
+///       solver steps on. At most two blocks wait for that thread: when both
+///       are taken, `write` waits for it (the memory stays bounded).
+///       With a tolerance > 0 every stored value is within `tolerance` of the
+///       solver's value, so the error norms of Norms computed on the decoded
+///       field move by at most tolerance (LInf), N * tolerance (L1) and
+///       N^(1/p) * tolerance (L2, Lp).
+class CompressedSink : public RowSink {
+public:
+    /// @brief Constructor
+    /// @param filename The output file (conventionally with a .wez extension)
+    /// @param tolerance Absolute error bound (0: lossless)
+    /// @param blockRows Levels per block (the most rows decoded to read one level)
+    CompressedSink(const std::string& filename, double tolerance = 0, int blockRows = 32)
+        : filename(filename), tolerance(tolerance > 0 ? tolerance : 0), blockRows(std::max(1, blockRows)) {}
+
+    CompressedSink(const CompressedSink&) = delete;
+    CompressedSink& operator=(const CompressedSink&) = delete;
+
+    ~CompressedSink() {
+        if (worker.joinable()) stop();
+    }
+
+    void begin(const RunInfo& info) override {
+        if (worker.joinable()) stop();
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, COMPRESSED_MAGIC, sizeof(COMPRESSED_MAGIC));
+        header.version = 1;
+        header.mode = tolerance > 0 ? 1 : 0;
+        std::strncpy(header.scheme, info.scheme.c_str(), sizeof(header.scheme) - 1);
+        std::strncpy(header.bondary, info.bondary.c_str(), sizeof(header.bondary) - 1);
+        header.N = info.N;
+        header.dt = info.dt;
+        header.dx = info.dx;
+        header.x_min = info.x_min;
+        header.CFL = info.CFL;
+        header.u = info.u;
+        header.tolerance = tolerance;
+        header.block_rows = blockRows;
+        N = std::max(0, info.N);
+        levels.clear();
+        times.clear();
+        index.clear();
+        queue.clear();
+        stats = CompressionMetrics();
+
+        out.open(filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        offset = sizeof(header);
+        current.assign(static_cast<size_t>(blockRows) * N, 0.0);
+        filled = 0;
+        stopping = false;
+        worker = std::thread([this]() { work(); });
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        if (!out.is_open()) return;
+        double* target = current.data() + static_cast<size_t>(filled) * N;
+        const int count = std::max(0, std::min(n, N));
+        std::copy(row, row + count, target);
+        std::fill(target + count, target + N, 0.0);
+        levels.push_back(level);
+        times.push_back(t);
+        stats.rows++;
+        if (++filled == blockRows) submit();
+    }
+
+    void end() override {
+        if (!out.is_open()) return;
+        if (filled > 0) submit();
+        stop();
+        header.rows = static_cast<int64_t>(levels.size());
+        header.blocks = static_cast<int64_t>(index.size() / 2);
+        header.index_offset = offset;
+        out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(int64_t));
+        header.table_offset = offset + static_cast<int64_t>(index.size() * sizeof(int64_t));
+        for (size_t i = 0; i < levels.size(); i++) {
+            out.write(reinterpret_cast<const char*>(&levels[i]), sizeof(int64_t));
+            out.write(reinterpret_cast<const char*>(&times[i]), sizeof(double));
+        }
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!out) std::cerr << "Error writing file: " << filename << std::endl;
+        out.close();
+        stats.blocks = header.blocks;
+        stats.rawBytes = header.rows * header.N * static_cast<long long>(sizeof(double));
+        stats.fileBytes = header.table_offset + header.rows * 16;
+    }
+
+    /// @brief Counters of the last run (complete once `end` has returned)
+    const CompressionMetrics& metrics() const { return stats; }
+
+private:
+    struct Block {
+        std::vector<double> values;
+        int rows;
+    };
+
+    /// @brief Hands the current block to the compression thread
+    void submit() {
+        std::unique_lock<std::mutex> lock(mutex);
+        room.wait(lock, [this]() { return queue.size() < 2; });
+        queue.push_back(Block{std::move(current), filled});
+        if (!spares.empty()) {
+            current.swap(spares.back());
+            spares.pop_back();
+        }
+        current.resize(static_cast<size_t>(blockRows) * N);
+        filled = 0;
+        ready.notify_one();
+    }
+
+    /// @brief Compresses the queued blocks and joins the thread
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_one();
+        worker.join();
+    }
+
+    void work() {
+        FieldCodec codec(tolerance);
+        std::vector<uint64_t> state(N);
+        std::vector<uint8_t> bytes;
+        double busy = 0;
+        while (true) {
+            Block block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty()) break;
+                block = std::move(queue.front());
+                queue.pop_front();
+            }
+            room.notify_one();
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            {
+                PROFILE_SCOPE("compress");
+                bytes.clear();
+                for (int r = 0; r < block.rows; r++) {
+                    codec.encode(block.values.data() + static_cast<size_t>(r) * N, N, r == 0, state.data(), bytes);
+                }
+                out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+                PROFILE_COUNT("bytes_written", bytes.size());
+                index.push_back(offset);
+                index.push_back(static_cast<int64_t>(bytes.size()));
+                offset += static_cast<int64_t>(bytes.size());
+            }
+            busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            spares.push_back(std::move(block.values));
+        }
+        stats.maxError = codec.maxError;
+        stats.escapes = codec.escapes;
+        stats.compressSeconds = busy;
+    }
+
+    std::string filename;
+    double tolerance;
+    int blockRows;
+    int N = 0;
+    std::ofstream out;
+    CompressedHeader header;
+    std::vector<int64_t> levels;
+    std::vector<double> times;
+    std::vector<int64_t> index;     ///< (offset, bytes) of every written block
+    int64_t offset = 0;             ///< Where the next block starts
+    std::vector<double> current;    ///< Block being filled by `write`
+    int filled = 0;
+    std::deque<Block> queue;
+    std::vector<std::vector<double>> spares;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable room;
+    bool stopping = false;
+    std::thread worker;
+    CompressionMetrics stats;
+};
+
+/// @class CompressedResultFile
+/// @brief Memory-mapped compressed result file with on-demand decoding of single levels
+/// @note The last decoded row and its block position are kept, so reading the
+///       levels in order decodes each row once. Not safe for concurrent reads.
+class CompressedResultFile {
+public:
+    CompressedResultFile() {}
+    CompressedResultFile(const CompressedResultFile&) = delete;
+    CompressedResultFile& operator=(const CompressedResultFile&) = delete;
+    ~CompressedResultFile() { close(); }
+
+    /// @brief Maps a compressed result file
+    /// @param filename The file to open
+    /// @return True on success; errors are reported on std::cerr
+    bool open(const std::string& filename) {
+        close();
+        if (!file.open(filename)) {
+            return false;
+        }
+        base = file.data();
+        length = file.size();
+        if (!validate()) {
+            std::cerr << "Error: " << filename << " is not a valid compressed result file" << std::endl;
+            close();
+            return false;
+        }
+        codec = FieldCodec(info().tolerance);
+        state.assign(static_cast<size_t>(N()), 0);
+        current.assign(static_cast<size_t>(N()), 0.0);
+        return true;
+    }
+
+    /// @brief Unmaps the file
+    void close() {
+        file.close();
+        base = nullptr;
+        length = 0;
+        cachedBlock = -1;
+        nextRow = 0;
+    }
+
+    const CompressedHeader& info() const { return *reinterpret_cast<const CompressedHeader*>(base); }
+    int64_t rows() const { return info().rows; }
+    int64_t N() const { return info().N; }
+    bool isLossless() const { return info().mode == 0; }
+    double tolerance() const { return info().tolerance; }
+
+    /// @brief x coordinate of column j
+    double x(int64_t j) const { return info().x_min + j * info().dx; }
+
+    /// @brief Time level index of row i
+    int64_t level(int64_t i) const {
+        int64_t value;
+        std::memcpy(&value, base + info().table_offset + i * 16, sizeof(value));
+        return value;
+    }
+
+    /// @brief Time of row i
+    double t(int64_t i) const {
+        double value;
+        std::memcpy(&value, base + info().table_offset + i * 16 + 8, sizeof(value));
+        return value;
+    }
+
+    /// @brief Decodes row i
+    /// @param i The row
+    /// @param row Receives the N values
+    /// @return False if the block is corrupted
+    bool readRow(int64_t i, double* row) {
+        PROFILE_SCOPE("decompress");
+        const int64_t block = i / info().block_rows;
+        const int64_t first = block * info().block_rows;
+        if (block != cachedBlock || i < nextRow - 1) {
+            int64_t entry[2];
+            std::memcpy(entry, base + info().index_offset + block * 16, sizeof(entry));
+            cursor = reinterpret_cast<const uint8_t*>(base) + entry[0];
+            blockEnd = cursor + entry[1];
+            cachedBlock = block;
+            nextRow = first;
+        }
+        while (nextRow <= i) {
+            cursor = codec.decode(cursor, blockEnd, static_cast<int>(N()), nextRow == first, state.data(), current.data());
+            if (!cursor) {
+                std::cerr << "Error reading block " << block << " of a compressed result file" << std::endl;
+                cachedBlock = -1;
+                return false;
+            }
+            nextRow++;
+        }
+        std::copy(current.begin(), current.end(), row);
+        return true;
+    }
+
+    /// @brief Decodes row i into a double vector (empty if the block is corrupted)
+    std::vector<double> readRow(int64_t i) {
+        std::vector<double> result(static_cast<size_t>(N()));
+        if (!readRow(i, result.data())) result.clear();
+        return result;
+    }
+
+private:
+    bool validate() const {
+        if (length < sizeof(CompressedHeader)) return false;
+        const CompressedHeader& h = info();
+        if (std::memcmp(h.magic, COMPRESSED_MAGIC, sizeof(COMPRESSED_MAGIC)) != 0) return false;
+        if (h.version != 1 || h.mode > 1 || (h.mode == 1) != (h.tolerance > 0)) return false;
+        if (h.N < 0 || h.rows < 0 || h.block_rows < 1 || h.blocks != (h.rows + h.block_rows - 1) / h.block_rows) return false;
+        if (h.index_offset < static_cast<int64_t>(sizeof(CompressedHeader)) || h.table_offset != h.index_offset + h.blocks * 16) return false;
+        if (static_cast<size_t>(h.table_offset + h.rows * 16) > length) return false;
+        for (int64_t b = 0; b < h.blocks; b++) {
+            int64_t entry[2];
+            std::memcpy(entry, base + h.index_offset + b * 16, sizeof(entry));
+            if (entry[0] < static_cast<int64_t>(sizeof(CompressedHeader)) || entry[1] < 0 || entry[0] + entry[1] > h.index_offset) return false;
+        }
+        return true;
+    }
+
+    MappedFile file;
+    const char* base = nullptr;
+    size_t length = 0;
+    FieldCodec codec;
+    std::vector<uint64_t> state;     ///< Symbols of the last decoded row
+    std::vector<double> current;     ///< Last decoded row
+    int64_t cachedBlock = -1;        ///< Block of the last decoded row
+    int64_t nextRow = 0;             ///< Row the cursor decodes next
+    const uint8_t* cursor = nullptr;
+    const uint8_t* blockEnd = nullptr;
+};
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+#include "WaveEquationSolver.cpp"
+#include "Sweep.cpp"
+#include "NormSink.cpp"
+#include "Resample.cpp"
+
+/// @struct ConvergenceOptions
+/// @brief Parameters of a grid-convergence study
+struct ConvergenceOptions {
+    /// @enum Reference
+    /// @brief What the errors are measured against
+    enum Reference {
+        Exact,      ///< The advected initial profile u0(x - u t)
+        Richardson  ///< Richardson extrapolation of the two finest levels
+    };
+
+    int N0 = 100;              ///< Points of the coarsest level
+    int ratio = 2;             ///< Refinement ratio between levels (N and dt together, CFL fixed)
+    int minLevels = 3;         ///< Levels always run before testing for the asymptotic range
+    int maxLevels = 8;         ///< Upper bound on the number of levels
+    double tolerance = 0.05;   ///< Asymptotic once two successive observed orders differ by less
+    Reference reference = Exact;
+    std::vector<Norms::NormType> norms = {Norms::NormType::L1, Norms::NormType::L2, Norms::NormType::LInf};
+    double p = 2.5;            ///< Exponent of the Lp norm when requested
+    unsigned threads = 0;      ///< Levels solved concurrently (0: one per hardware thread)
+};
+
+/// @struct ConvergenceLevel
+/// @brief Result of one refinement level
+struct ConvergenceLevel {
+    int N;              ///< Number of points
+    double dx;          ///< Spatial step
+    double dt;          ///< Time step
+    double t;           ///< Time at which the error is measured
+    NormRecord error;   ///< Grid-weighted error norms (dx quadrature)
+    NormRecord order;   ///< Observed order against the previous level (NaN when not available)
+    double seconds;     ///< Wall time of the solve
+};
+
+/// @class ConvergenceStudy
+/// @brief Refines a run until the observed order of accuracy settles
+/// @note Levels are solved concurrently in batches of one level per thread; after
+///       each batch the observed orders are updated and refinement stops once the
+///       last two orders of every norm agree within the tolerance. Only the final
+///       level of each solve is observed, at a time t_end that is a whole number of
+///       steps on every level, so nothing but a table of norms is produced.
+///       With the Richardson reference the levels are compared on the coarsest grid,
+///       where the nested finer grids inject exactly, and the order comes from the
+///       differences between successive levels, so no exact solution is needed.
+class ConvergenceStudy {
+public:
+    /// @brief Constructor
+    /// @param base Input of the coarsest level (its N is replaced by options.N0)
+    /// @param options Study parameters
+    ConvergenceStudy(const Input& base, const ConvergenceOptions& options) : base(base), options(options) {
+        this->base.N = options.N0;
+    }
+
+    /// @brief Runs the study for one scheme
+    /// @param scheme The scheme
+    /// @return One entry per level that was run
+    std::vector<ConvergenceLevel> run(WaveEquationSolver::Scheme scheme) {
+        // Measurement time: a whole number of coarse steps, hence of steps on every level
+        WaveEquationSolver coarse(inputFor(0));
+        const double t_end = std::max(0, coarse.stepCount(scheme) - 1) * coarse.dt;
+
+        std::vector<ConvergenceLevel> levels;
+        std::vector<std::vector<double>> finalRows;
+        unsigned batch = std::max(2u, options.threads ? options.threads : std::thread::hardware_concurrency());
+        asymptotic = false;
+
+        while (static_cast<int>(levels.size()) < options.maxLevels && !asymptotic) {
+            // Next batch of levels, solved concurrently
+            std::vector<SweepJob> jobs;
+            const int first = static_cast<int>(levels.size());
+            const int count = std::min<int>(batch, options.maxLevels - first);
+            for (int k = first; k < first + count; k++) {
+                SweepJob job;
+                job.index = k - first;
+                job.input = inputFor(k);
+                job.scheme = scheme;
+                job.name = WaveEquationSolver::schemeName(scheme) + "_" + std::to_string(job.input.N);
+                jobs.push_back(job);
+            }
+            levels.resize(first + count);
+            finalRows.resize(first + count);
+
+            SweepRunner runner(options.threads, false);
+            runner.run(jobs, [&](WaveEquationSolver& solver, SweepJob& job) {
+                ConvergenceLevel& level = levels[first + job.index];
+                level.N = job.input.N;
+                level.dx = solver.dx;
+                level.dt = solver.dt;
+
+                RecordPolicy policy;
+                policy.every = 0;
+                policy.snapshot_times = {t_end};
+                NormSink errors(options.norms, options.p, solver.exactSolution(), true);
+                // Richardson extrapolation needs the final rows; the exact error only the norms
+                const bool keepRow = (options.reference == ConvergenceOptions::Richardson);
+                std::vector<double>& row = finalRows[first + job.index];
+                CallbackSink keep([&](int index, double t, const double* values, int n) {
+                    level.t = t;
+                    if (keepRow) row.assign(values, values + n);
+                });
+                TeeSink tee({&keep, &errors});
+                solver.solve(job.scheme, tee, policy);
+                level.error = errors.last();
+            });
+            for (const SweepJob& job : jobs) {
+                levels[first + job.index].seconds = job.seconds;
+            }
+
+            if (options.reference == ConvergenceOptions::Richardson) {
+                richardsonErrors(levels, finalRows);
+            }
+            updateOrders(levels);
+        }
+        return levels;
+    }
+
+    /// @brief Whether the last run reached the asymptotic range before maxLevels
+    bool reachedAsymptotic() const { return asymptotic; }
+
+    /// @brief Writes the compact table: one line per level with errors and observed orders
+    /// @param out The stream (a CSV file or std::cout)
+    /// @param scheme Scheme name written in the first column
+    /// @param levels The levels returned by run
+    /// @param header Whether to write the header line
+    void writeTable(std::ostream& out, const std::string& scheme, const std::vector<ConvergenceLevel>& levels, bool header = true) const {
+        NormSink names(options.norms, options.p);
+        std::vector<std::string> columns;
+        std::string list = names.header();
+        for (size_t start = 0; start <= list.size();) {
+            size_t comma = std::min(list.find(',', start), list.size());
+            columns.push_back(list.substr(start, comma - start));
+            start = comma + 1;
+        }
+        if (header) {
+            out << "Scheme,Reference,Level,N,dx,dt,t";
+            for (const std::string& column : columns) out << "," << column << ",order_" << column;
+            out << ",seconds\n";
+        }
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision(8);
+        for (size_t k = 0; k < levels.size(); k++) {
+            const ConvergenceLevel& level = levels[k];
+            out << scheme << "," << (options.reference == ConvergenceOptions::Exact ? "exact" : "richardson") << "," << k << ","
+                << level.N << "," << level.dx << "," << level.dt << "," << level.t;
+            for (Norms::NormType type : options.norms) {
+                out << "," << level.error.get(type) << "," << level.order.get(type);
+            }
+            out << "," << level.seconds << "\n";
+        }
+        out.precision(precision);
+        out.flags(flags);
+    }
+
+private:
+    Input inputFor(int level) const {
+        Input input = base;
+        input.N = options.N0 * static_cast<int>(std::lround(std::pow(options.ratio, level)));
+        return input;
+    }
+
+    /// @brief Observed orders and the asymptotic-range test
+    void updateOrders(std::vector<ConvergenceLevel>& levels) {
+        const double logRatio = std::log(static_cast<double>(options.ratio));
+        // Exact: errors of levels k - 1 and k. Richardson: differences (k - 2, k - 1) and (k - 1, k)
+        const bool exact = (options.reference == ConvergenceOptions::Exact);
+        const std::vector<NormRecord> source = exact ? errorsOf(levels) : differences;
+        for (size_t k = 0; k < levels.size(); k++) {
+            NormRecord& order = levels[k].order;
+            order = NormRecord{0, levels[k].t, NAN, NAN, NAN, NAN};
+            const size_t a = exact ? k : k - 1;
+            if (k < (exact ? 1u : 2u) || a >= source.size()) continue;
+            order.l1 = std::log(source[a - 1].l1 / source[a].l1) / logRatio;
+            order.l2 = std::log(source[a - 1].l2 / source[a].l2) / logRatio;
+            order.linf = std::log(source[a - 1].linf / source[a].linf) / logRatio;
+            order.lp = std::log(source[a - 1].lp / source[a].lp) / logRatio;
+        }
+
+        asymptotic = false;
+        if (static_cast<int>(levels.size()) < options.minLevels || levels.size() < 2) return;
+        const NormRecord& last = levels[levels.size() - 1].order;
+        const NormRecord& previous = levels[levels.size() - 2].order;
+        // Settled and positive: a scheme that does not converge never counts as asymptotic
+        asymptotic = true;
+        for (Norms::NormType type : options.norms) {
+            double a = last.get(type), b = previous.get(type);
+            if (!(std::fabs(a - b) < options.tolerance && a > options.tolerance)) asymptotic = false;
+        }
+    }
+
+    static std::vector<NormRecord> errorsOf(const std::vector<ConvergenceLevel>& levels) {
+        std::vector<NormRecord> errors;
+        for (const ConvergenceLevel& level : levels) errors.push_back(level.error);
+        return errors;
+    }
+
+    /// @brief Errors against the Richardson extrapolation of the two finest levels
+    /// @note Two levels are compared on the coarser of their grids, where the nested
+    ///       finer grid injects exactly (cubic interpolation for non-nested grids).
+    ///       differences[k] is the norm of level k + 1 - level k on grid k. The
+    ///       reference lives on the grid of the second finest level and uses the L2
+    ///       order of the last two differences, or order 1 while fewer than three
+    ///       levels exist.
+    void richardsonErrors(std::vector<ConvergenceLevel>& levels, const std::vector<std::vector<double>>& rows) {
+        const size_t n = levels.size();
+        const double lp = hasLp() ? options.p : 0;
+        differences.clear();
+        for (size_t k = 0; k + 1 < n; k++) {
+            differences.push_back(normOf(mapRow(levels, rows[k + 1], k + 1, k), rows[k], levels[k].dx, lp));
+        }
+        if (n < 2) return;
+
+        double order = 1;
+        if (differences.size() >= 2) {
+            const NormRecord& a = differences[differences.size() - 2];
+            const NormRecord& b = differences[differences.size() - 1];
+            double observed = std::log(a.l2 / b.l2) / std::log(static_cast<double>(options.ratio));
+            if (std::isfinite(observed) && observed > 0) order = observed;
+        }
+        const size_t base = n - 2;
+        const std::vector<double> fine = mapRow(levels, rows[n - 1], n - 1, base);
+        const std::vector<double>& coarse = rows[base];
+        const double factor = 1.0 / (std::pow(static_cast<double>(options.ratio), order) - 1.0);
+        std::vector<double> reference(fine.size());
+        for (size_t i = 0; i < fine.size(); i++) {
+            reference[i] = fine[i] + (fine[i] - coarse[i]) * factor;
+        }
+
+        for (size_t k = 0; k < n; k++) {
+            if (k <= base) {
+                levels[k].error = normOf(rows[k], mapRow(levels, reference, base, k), levels[k].dx, lp);
+            } else {
+                levels[k].error = normOf(fine, reference, levels[base].dx, lp);
+            }
+            levels[k].error.t = levels[k].t;
+        }
+    }
+
+    /// @brief Maps a row from the grid of level `from` onto the grid of level `to`
+    std::vector<double> mapRow(const std::vector<ConvergenceLevel>& levels, const std::vector<double>& row, size_t from, size_t to) const {
+        if (from == to) return row;
+        ResampleGrid source = {base.x_min, levels[from].dx, levels[from].N};
+        ResampleGrid target = {base.x_min, levels[to].dx, levels[to].N};
+        return ResamplePlan::make(ResamplePlan::Method::Cubic, source, target).apply(row);
+    }
+
+    bool hasLp() const {
+        return std::find(options.norms.begin(), options.norms.end(), Norms::NormType::Lp) != options.norms.end();
+    }
+
+    static NormRecord normOf(const std::vector<double>& a, const std::vector<double>& b, double dx, double p) {
+        std::vector<double> difference(a.size());
+        for (size_t i = 0; i < a.size(); i++) difference[i] = a[i] - b[i];
+        NormAccumulator acc(p);
+        acc.add(difference.data(), difference.size());
+        return NormSink::record(0, 0, acc, dx);
+    }
+
+    Input base;
+    ConvergenceOptions options;
+    std::vector<NormRecord> differences; ///< Richardson mode: norms of level k + 1 - level k
+    bool asymptotic = false;
+};
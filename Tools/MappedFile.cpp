@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For close
+#endif
+
+/// @class MappedFile
+/// @brief Read-only memory mapping of a whole file
+/// @note On Windows the file is read into memory instead of being mapped
+class MappedFile {
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    /// @brief Maps a file
+    /// @param filename The file to open
+    /// @return True on success; errors are reported on std::cerr
+    bool open(const std::string& filename) {
+        close();
+#ifdef _WIN32
+        std::ifstream in(filename, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return false;
+        }
+        copy.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(copy.data(), copy.size());
+        base = copy.data();
+        length = copy.size();
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            std::cerr << "Error reading file: " << filename << std::endl;
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                length = 0;
+                std::cerr << "Error mapping file: " << filename << std::endl;
+                return false;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            base = static_cast<const char*>(mapped);
+            mappedFile = true;
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    /// @brief Unmaps the file
+    void close() {
+#ifndef _WIN32
+        if (mappedFile) {
+            munmap(const_cast<char*>(base), length);
+        }
+#endif
+        copy.clear();
+        base = nullptr;
+        length = 0;
+        mappedFile = false;
+    }
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+    bool mappedFile = false;
+    std::vector<char> copy;
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <functional>
+#include <cmath>
+
+#include "Norms.cpp"
+#include "Output.cpp"
+#include "Profiler.cpp"
+
+/// @struct NormRecord
+/// @brief Norms of one recorded time level (NaN for norms that were not requested)
+struct NormRecord {
+    int level;    ///< Index of the time level
+    double t;     ///< Time of the level
+    double l1;    ///< L1 norm
+    double l2;    ///< L2 norm
+    double linf;  ///< LInf norm
+    double lp;    ///< Lp norm
+
+    /// @brief Value of one norm
+    double get(Norms::NormType type) const {
+        switch (type) {
+        case Norms::NormType::L1: return l1;
+        case Norms::NormType::L2: return l2;
+        case Norms::NormType::LInf: return linf;
+        case Norms::NormType::Lp: return lp;
+        default: return NAN;
+        }
+    }
+};
+
+/// @class NormSink
+/// @brief Accumulates norms of every recorded level while the solver runs
+/// @note With an exact solution the norms are those of the error row - exact(x, t),
+///       otherwise of the row itself. Each level gets its own NormAccumulator, and a
+///       run-wide accumulator folds all the levels together like NormsProduction does.
+///       Nothing but the per-level NormRecords is kept, so norms need no CSV round trip.
+class NormSink : public RowSink {
+public:
+    typedef std::function<double(double x, double t)> Exact;
+
+    /// @brief Constructor
+    /// @param norms The norms to report
+    /// @param p Exponent of the Lp norm
+    /// @param exact Exact solution (empty: norms of the solution itself)
+    /// @param gridWeighted Scale sums by dx (discrete L1(dx), L2(dx), Lp(dx) norms, comparable across N)
+    NormSink(const std::vector<Norms::NormType>& norms = {Norms::NormType::L1, Norms::NormType::L2, Norms::NormType::LInf},
+             double p = 2.5, Exact exact = Exact(), bool gridWeighted = false)
+        : norms(norms), p(p), exact(exact), gridWeighted(gridWeighted), overall(lpExponent()) {}
+
+    /// @brief Exact solution of the advection equation: the initial profile moved by u * t
+    /// @param t0_function The initial condition
+    /// @param u Advection velocity
+    static Exact advected(double (*t0_function)(double), double u) {
+        return [t0_function, u](double x, double t) { return t0_function(x - u * t); };
+    }
+
+    void begin(const RunInfo& info) override {
+        this->info = info;
+        records.clear();
+        overall = NormAccumulator(lpExponent());
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        PROFILE_SCOPE("norms");
+        const double* values = row;
+        if (exact) {
+            error.resize(n);
+            for (int i = 0; i < n; i++) {
+                double x = info.x_min + i * info.dx;
+                error[i] = row[i] - exact(x, t);
+            }
+            values = error.data();
+        }
+
+        NormAccumulator acc(lpExponent());
+        acc.add(values, n);
+        overall.merge(acc);
+        records.push_back(makeRecord(level, t, acc));
+    }
+
+    /// @brief Norms of every recorded level, in level order
+    const std::vector<NormRecord>& getRecords() const { return records; }
+
+    /// @brief Norms of the last recorded level
+    NormRecord last() const {
+        return records.empty() ? NormRecord{0, 0, NAN, NAN, NAN, NAN} : records.back();
+    }
+
+    /// @brief Norms of all the recorded levels folded into one vector
+    NormRecord total() const {
+        return makeRecord(records.empty() ? 0 : records.back().level, records.empty() ? 0 : records.back().t, overall);
+    }
+
+    /// @brief Norms of an accumulator as a record
+    /// @param level Index of the time level
+    /// @param t Time of the level
+    /// @param acc The accumulated values
+    /// @param weight Quadrature weight (dx for grid norms, 1 for plain sums)
+    static NormRecord record(int level, double t, const NormAccumulator& acc, double weight = 1.0) {
+        // Grid weighting turns the sums into quadratures: sum * dx, then the root
+        NormRecord record;
+        record.level = level;
+        record.t = t;
+        record.l1 = acc.L1() * weight;
+        record.l2 = acc.L2() * std::sqrt(weight);
+        record.linf = acc.LInf();
+        record.lp = (acc.exponent() > 0) ? acc.Lp() * std::pow(weight, 1.0 / acc.exponent()) : NAN;
+        return record;
+    }
+
+    /// @brief Description of the observed run
+    const RunInfo& run() const { return info; }
+
+    /// @brief Column header of the requested norms, e.g. "L1,L2,LInf,Lp(p=2.5)"
+    std::string header() const {
+        std::ostringstream out;
+        for (size_t k = 0; k < norms.size(); k++) {
+            if (k) out << ",";
+            switch (norms[k]) {
+            case Norms::NormType::L1: out << "L1"; break;
+            case Norms::NormType::L2: out << "L2"; break;
+            case Norms::NormType::LInf: out << "LInf"; break;
+            case Norms::NormType::Lp: out << "Lp(p=" << p << ")"; break;
+            }
+        }
+        return out.str();
+    }
+
+    /// @brief Writes the requested norms of a record as CSV fields
+    void writeFields(std::ostream& out, const NormRecord& record) const {
+        for (size_t k = 0; k < norms.size(); k++) {
+            if (k) out << ",";
+            out << record.get(norms[k]);
+        }
+    }
+
+    /// @brief Writes the per-level table `level,t,<norms>`
+    /// @param filename The output CSV file
+    /// @return False if the file cannot be created
+    bool writeTable(const std::string& filename) const {
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return false;
+        }
+        out << std::setprecision(10);
+        out << "level,t," << header() << "\n";
+        for (const NormRecord& record : records) {
+            out << record.level << "," << record.t << ",";
+            writeFields(out, record);
+            out << "\n";
+        }
+        return true;
+    }
+
+private:
+    double lpExponent() const {
+        for (Norms::NormType type : norms) {
+            if (type == Norms::NormType::Lp) return p;
+        }
+        return 0;
+    }
+
+    NormRecord makeRecord(int level, double t, const NormAccumulator& acc) const {
+        return NormSink::record(level, t, acc, gridWeighted ? info.dx : 1.0);
+    }
+
+    std::vector<Norms::NormType> norms;
+    double p;
+    Exact exact;
+    bool gridWeighted;
+    RunInfo info;
+    std::vector<double> error;
+    NormAccumulator overall;
+    std::vector<NormRecord> records;
+};
@@ -1,7 +1,13 @@
+#pragma once
+
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <numeric>
+#include <thread>
+
+#include "Parallel.cpp"
+#include "Resample.cpp"
 
 struct Norms
 {
@@ -96,6 +102,18 @@ struct Norms
         return result;
     }
 
+    /// @brief  Resample a vector to a given size with a precomputed plan
+    /// @param v the vector
+    /// @param newSize the target size
+    /// @param method the interpolation rule (Linear matches the long double overload)
+    /// @return resampled vector
+    /// @note To resample many rows build the ResamplePlan once and use applyRows
+    static std::vector<double> interpolate(const std::vector<double>& v, size_t newSize,
+                                           ResamplePlan::Method method = ResamplePlan::Method::Linear)
+    {
+        return ResamplePlan::make(method, static_cast<int>(v.size()), static_cast<int>(newSize)).apply(v);
+    }
+
     /// @brief  Normalize the Norm of a vector
     /// @param v_1 the 1st vector
     /// @param v_2 the 2nd vector
@@ -107,4 +125,278 @@ struct Norms
         long double norm = calcNorm(error_v, normType, p);
         return norm / len_error;
     }
-};
\ No newline at end of file
+};
+
+/// @class NormAccumulator
+/// @brief Single-pass accumulation of the L1, L2, LInf and Lp norms in double precision
+/// @note Values are reduced in blocks of BLOCK elements over LANES independent partial
+///       sums (one SIMD register's worth each, so the loop vectorises), the lanes are
+///       combined pairwise and the block sums are added with Kahan compensation. The
+///       rounding error stays at a few ulp of the result without long double.
+///       |x|^p uses repeated squaring for integer p, an extra sqrt for half-integer p
+///       (p = 2.5 is x * x * sqrt(x)) and std::pow otherwise.
+class NormAccumulator
+{
+public:
+    static constexpr int LANES = 8;
+    static constexpr size_t BLOCK = 4096;
+
+    /// @brief Constructor
+    /// @param p Exponent of the Lp norm (0: no Lp norm)
+    NormAccumulator(double p = 0) : p(p)
+    {
+        double twice = 2 * p;
+        if (p <= 0)
+            kind = Power::None;
+        else if (p == std::floor(p) && p <= 64)
+            kind = Power::Integer;
+        else if (twice == std::floor(twice) && p <= 64)
+            kind = Power::HalfInteger;
+        else
+            kind = Power::General;
+        m = static_cast<int>(std::floor(p));
+    }
+
+    /// @brief Adds values to the reduction
+    /// @param v the values
+    /// @param n the number of values
+    void add(const double* v, size_t n)
+    {
+        switch (kind)
+        {
+        case Power::None: addBlocks<Power::None>(v, n); break;
+        case Power::Integer: addBlocks<Power::Integer>(v, n); break;
+        case Power::HalfInteger: addBlocks<Power::HalfInteger>(v, n); break;
+        case Power::General: addBlocks<Power::General>(v, n); break;
+        }
+    }
+
+    /// @brief Adds the values reduced by another accumulator with the same p
+    void merge(const NormAccumulator& other)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            kahanAdd(k, other.sum[k]);
+            kahanAdd(k, -other.carry[k]);
+        }
+        max = std::max(max, other.max);
+        n += other.n;
+    }
+
+    size_t count() const { return n; }
+    double exponent() const { return p; }
+
+    /// @brief Sum of |x|
+    double L1() const { return sum[0]; }
+
+    /// @brief Square root of the sum of x^2
+    double L2() const { return std::sqrt(sum[1]); }
+
+    /// @brief Largest |x|
+    double LInf() const { return max; }
+
+    /// @brief (sum of |x|^p)^(1/p), NaN when no p was requested
+    double Lp() const { return (kind == Power::None) ? NAN : std::pow(sum[2], 1.0 / p); }
+
+private:
+    enum class Power { None, Integer, HalfInteger, General };
+
+    template <Power P>
+    void addBlocks(const double* v, size_t count)
+    {
+        for (size_t start = 0; start < count; start += BLOCK)
+        {
+            size_t len = std::min(BLOCK, count - start);
+            double block[3];
+            double blockMax = reduceBlock<P>(v + start, len, block);
+            for (int k = 0; k < 3; k++)
+                kahanAdd(k, block[k]);
+            max = std::max(max, blockMax);
+        }
+        n += count;
+    }
+
+    template <Power P>
+    double reduceBlock(const double* v, size_t len, double out[3]) const
+    {
+        double s1[LANES] = {}, s2[LANES] = {}, sp[LANES] = {}, mx[LANES] = {};
+        double a[LANES], r[LANES];
+        size_t i = 0;
+        for (; i + LANES <= len; i += LANES)
+        {
+            for (int l = 0; l < LANES; l++)
+            {
+                a[l] = std::fabs(v[i + l]);
+                s1[l] += a[l];
+                s2[l] += a[l] * a[l];
+                mx[l] = std::max(mx[l], a[l]);
+            }
+            if (P != Power::None)
+            {
+                power<P>(a, r, LANES);
+                for (int l = 0; l < LANES; l++)
+                    sp[l] += r[l];
+            }
+        }
+        // Tail: fewer than LANES values, one per lane
+        int tail = static_cast<int>(len - i);
+        for (int l = 0; l < tail; l++)
+        {
+            a[l] = std::fabs(v[i + l]);
+            s1[l] += a[l];
+            s2[l] += a[l] * a[l];
+            mx[l] = std::max(mx[l], a[l]);
+        }
+        if (P != Power::None && tail > 0)
+        {
+            power<P>(a, r, tail);
+            for (int l = 0; l < tail; l++)
+                sp[l] += r[l];
+        }
+
+        out[0] = pairwise(s1);
+        out[1] = pairwise(s2);
+        out[2] = pairwise(sp);
+        double blockMax = 0;
+        for (int l = 0; l < LANES; l++)
+            blockMax = std::max(blockMax, mx[l]);
+        return blockMax;
+    }
+
+    /// @brief r[l] = a[l]^p for the first `len` lanes
+    template <Power P>
+    void power(const double* a, double* r, int len) const
+    {
+        if (P == Power::General)
+        {
+            for (int l = 0; l < len; l++)
+                r[l] = std::pow(a[l], p);
+            return;
+        }
+        double b[LANES];
+        for (int l = 0; l < len; l++)
+        {
+            r[l] = 1;
+            b[l] = a[l];
+        }
+        for (int e = m; e > 0; e >>= 1)
+        {
+            if (e & 1)
+                for (int l = 0; l < len; l++)
+                    r[l] *= b[l];
+            for (int l = 0; l < len; l++)
+                b[l] *= b[l];
+        }
+        if (P == Power::HalfInteger)
+            for (int l = 0; l < len; l++)
+                r[l] *= std::sqrt(a[l]);
+    }
+
+    static double pairwise(const double* s)
+    {
+        return ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7]));
+    }
+
+    void kahanAdd(int k, double value)
+    {
+        double y = value - carry[k];
+        double t = sum[k] + y;
+        carry[k] = (t - sum[k]) - y;
+        sum[k] = t;
+    }
+
+    double p;
+    Power kind;
+    int m;                         ///< Integer part of p
+    double sum[3] = {0, 0, 0};     ///< Sums of |x|, x^2 and |x|^p
+    double carry[3] = {0, 0, 0};   ///< Kahan compensation terms
+    double max = 0;
+    size_t n = 0;
+};
+
+struct FusedNorms
+{
+    /// @brief Minimum number of values per thread of a multithreaded reduction
+    static const size_t MIN_VALUES_PER_THREAD = 1 << 18;
+
+    /// @brief  L1, L2, LInf and Lp norms of a vector in one pass
+    /// @param v the values
+    /// @param n the number of values
+    /// @param p exponent of the Lp norm (0: no Lp norm)
+    /// @param threads number of threads (0: one per hardware thread); inputs shorter than
+    ///        MIN_VALUES_PER_THREAD per thread use fewer
+    /// @return the accumulated norms; the result depends only on n and the thread count
+    static NormAccumulator compute(const double* v, size_t n, double p = 0, unsigned threads = 0)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t parts = std::max<size_t>(1, std::min<size_t>(threads, n / MIN_VALUES_PER_THREAD));
+
+        std::vector<NormAccumulator> partial(parts, NormAccumulator(p));
+        if (parts == 1)
+        {
+            partial[0].add(v, n);
+            return partial[0];
+        }
+
+        // Chunks in units of a block so the block boundaries do not depend on the split
+        size_t blocks = (n + NormAccumulator::BLOCK - 1) / NormAccumulator::BLOCK;
+        std::vector<int> bounds = splitRange(0, static_cast<int>(blocks), static_cast<int>(parts), 1);
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < parts; t++)
+        {
+            workers.emplace_back([&, t]() { addChunk(partial[t], v, n, bounds[t], bounds[t + 1]); });
+        }
+        addChunk(partial[0], v, n, bounds[0], bounds[1]);
+        for (std::thread& worker : workers)
+            worker.join();
+
+        for (size_t t = 1; t < parts; t++)
+            partial[0].merge(partial[t]);
+        return partial[0];
+    }
+
+    static NormAccumulator compute(const std::vector<double>& v, double p = 0, unsigned threads = 0)
+    {
+        return compute(v.data(), v.size(), p, threads);
+    }
+
+private:
+    static void addChunk(NormAccumulator& acc, const double* v, size_t n, int firstBlock, int lastBlock)
+    {
+        size_t begin = std::min(n, static_cast<size_t>(firstBlock) * NormAccumulator::BLOCK);
+        size_t end = std::min(n, static_cast<size_t>(lastBlock) * NormAccumulator::BLOCK);
+        acc.add(v + begin, end - begin);
+    }
+};
+
+/// @brief Norms of the difference between resampled rows and reference rows
+/// @param plan maps a row of `rows` onto the grid of `reference`
+/// @param rows first row to resample
+/// @param rowStride distance between rows (elements)
+/// @param reference first reference row
+/// @param referenceStride distance between reference rows (elements)
+/// @param count number of rows
+/// @param p exponent of the Lp norm (0: no Lp norm)
+/// @return the norms of plan(rows) - reference over all the rows
+inline NormAccumulator resampledError(const ResamplePlan& plan, const double* rows, size_t rowStride,
+                                      const double* reference, size_t referenceStride, size_t count, double p = 0)
+{
+    NormAccumulator acc(p);
+    const size_t batch = 64;
+    std::vector<double> resampled(batch * plan.size());
+    for (size_t r = 0; r < count; r += batch)
+    {
+        size_t n = std::min(batch, count - r);
+        plan.applyRows(rows + r * rowStride, rowStride, resampled.data(), plan.size(), n);
+        for (size_t k = 0; k < n; k++)
+        {
+            double* d = resampled.data() + k * plan.size();
+            const double* ref = reference + (r + k) * referenceStride;
+            for (int i = 0; i < plan.size(); i++)
+                d[i] -= ref[i];
+        }
+        acc.add(resampled.data(), n * plan.size());
+    }
+    return acc;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+#include "CSVWriter.cpp"
+
+/// @struct RunInfo
+/// @brief Describes the run that produces a stream of time levels
+struct RunInfo {
+    std::string scheme;  ///< Scheme name as used in result file names (E_FTBS, I_FTBS, LW, Richtmyer)
+    std::string bondary; ///< Boundary set name (SET1_sign, SET2_exp, ...)
+    int N;               ///< Number of spatial points per level
+    double dt;           ///< Time step size
+    double dx;           ///< Spatial step size
+    double x_min;        ///< Minimum x value of the domain
+    double CFL;          ///< Courant-Friedrichs-Lewy number
+    double u;            ///< Advection velocity
+    int steps;           ///< Number of time steps after the initial level
+};
+
+/// @class RowSink
+/// @brief Receives completed time levels from a streaming solve
+/// @note The row pointer is only valid for the duration of the `write` call
+class RowSink {
+public:
+    virtual ~RowSink() {}
+
+    /// @brief Called once before the initial level is written
+    /// @param info Description of the run
+    virtual void begin(const RunInfo& info) {}
+
+    /// @brief Called for every recorded time level
+    /// @param level Index of the time level (0 is the initial condition)
+    /// @param t Time of the level
+    /// @param row The N values of the level
+    /// @param n Number of values in the row
+    virtual void write(int level, double t, const double* row, int n) = 0;
+
+    /// @brief Called once after the last level has been written
+    virtual void end() {}
+};
+
+/// @class CallbackSink
+/// @brief Forwards every recorded level to a user callback
+class CallbackSink : public RowSink {
+public:
+    typedef std::function<void(int level, double t, const double* row, int n)> Callback;
+
+    CallbackSink(Callback callback) : callback(callback) {}
+
+    void write(int level, double t, const double* row, int n) override {
+        callback(level, t, row, n);
+    }
+
+private:
+    Callback callback;
+};
+
+/// @class TeeSink
+/// @brief Forwards every level to several sinks
+class TeeSink : public RowSink {
+public:
+    TeeSink(std::vector<RowSink*> sinks) : sinks(sinks) {}
+
+    void begin(const RunInfo& info) override {
+        for (RowSink* sink : sinks) sink->begin(info);
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        for (RowSink* sink : sinks) sink->write(level, t, row, n);
+    }
+
+    void end() override {
+        for (RowSink* sink : sinks) sink->end();
+    }
+
+private:
+    std::vector<RowSink*> sinks;
+};
+
+/// @class CSVSink
+/// @brief Streams levels to a triple-column `x, t, f` CSV file through CSVWriter
+class CSVSink : public RowSink {
+public:
+    /// @brief Constructor
+    /// @param filename The output file
+    /// @param precision Significant digits, or CSVWriter::SHORTEST for round-trip output
+    CSVSink(const std::string& filename, int precision = 6) : filename(filename), writer(precision) {}
+
+    void begin(const RunInfo& info) override {
+        if (writer.open(filename)) {
+            writer.setColumns(info.x_min, info.dx, info.N);
+        }
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        writer.writeRow(t, row, n);
+    }
+
+    void end() override {
+        writer.close();
+    }
+
+private:
+    std::string filename;
+    CSVWriter writer;
+};
+
+/// @struct RecordPolicy
+/// @brief Selects which time levels of a streaming solve are sent to the sink
+struct RecordPolicy {
+    int every = 1;                      ///< Record every k-th level (0 records only the snapshots)
+    std::vector<double> snapshot_times; ///< Times to record, rounded to the nearest level
+    bool last = false;                  ///< Always record the final level
+
+    /// @brief Converts the snapshot times to sorted level indices for a given run
+    /// @param dt Time step size
+    /// @param steps Number of steps of the run
+    /// @return Sorted unique level indices
+    std::vector<int> snapshotLevels(double dt, int steps) const {
+        std::vector<int> levels;
+        for (double t : snapshot_times) {
+            long long level = std::llround(t / dt);
+            levels.push_back(static_cast<int>(std::min<long long>(std::max<long long>(level, 0), steps)));
+        }
+        std::sort(levels.begin(), levels.end());
+        levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+        return levels;
+    }
+};
+
+/// @class RecordSchedule
+/// @brief Answers "is level n recorded?" for a RecordPolicy applied to a given run
+class RecordSchedule {
+public:
+    /// @param policy The recorded levels
+    /// @param dt Time step size
+    /// @param steps Number of steps of the run
+    /// @param extra Also stop at every extra-th level (0: none), e.g. for checkpoints
+    RecordSchedule(const RecordPolicy& policy, double dt, int steps, int extra = 0)
+        : every(policy.every), extra(extra), last(policy.last), steps(steps), snapshots(policy.snapshotLevels(dt, steps)) {}
+
+    /// @brief Whether a level is sent to the sink
+    bool at(int level) const {
+        if (every > 0 && level % every == 0) return true;
+        if (extra > 0 && level % extra == 0) return true;
+        if (last && level == steps) return true;
+        return std::binary_search(snapshots.begin(), snapshots.end(), level);
+    }
+
+    /// @brief First recorded level after `level`, or the final level if none is
+    int next(int level) const {
+        int result = steps;
+        if (every > 0) {
+            result = std::min(result, (level / every + 1) * every);
+        }
+        if (extra > 0) {
+            result = std::min(result, (level / extra + 1) * extra);
+        }
+        std::vector<int>::const_iterator it = std::upper_bound(snapshots.begin(), snapshots.end(), level);
+        if (it != snapshots.end()) {
+            result = std::min(result, *it);
+        }
+        return std::max(result, level + 1);
+    }
+
+private:
+    int every;
+    int extra;
+    bool last;
+    int steps;
+    std::vector<int> snapshots;
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+// Hot-path instrumentation: scoped timers and counters aggregated per thread,
+// reported as a JSON summary and a Chrome trace (chrome://tracing, Perfetto).
+// Compile with -DWES_PROFILE to enable it; otherwise every PROFILE_* macro
+// expands to nothing and this file adds no code to the solver.
+//
+//   PROFILE_SCOPE("name");              times the enclosing block
+//   PROFILE_COUNT("name", value);       adds value to a counter
+//   PROFILE_REPORT(summary, trace);     writes the JSON files ("" skips one)
+//   PROFILE_RESET();                    forgets everything recorded so far
+//
+// Scope and counter names must be string literals. Nested scopes report both
+// their total time and their self time (total minus the enclosed scopes), so
+// "stepping" self time excludes the output sinks it calls. PROFILE_REPORT and
+// PROFILE_RESET must be called while no other thread is recording.
+
+#ifdef WES_PROFILE
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <map>
+
+/// @class Profiler
+/// @brief Registry of the per-thread timers, counters and trace events
+class Profiler {
+public:
+    /// @brief Most trace events kept per thread (later ones are only counted)
+    static const size_t MAX_EVENTS = 1 << 20;
+
+    struct Timer {
+        const char* name;
+        long long calls = 0;
+        int64_t totalNs = 0;
+        int64_t selfNs = 0;
+        int64_t maxNs = 0;
+    };
+
+    struct Counter {
+        const char* name;
+        long long value = 0;
+    };
+
+    struct Event {
+        const char* name;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    /// @brief Everything one thread recorded
+    struct Thread {
+        int id;
+        std::vector<Timer> timers;
+        std::vector<Counter> counters;
+        std::vector<Event> events;
+        size_t droppedEvents = 0;
+        int64_t* childNs = nullptr; ///< Time accumulator of the innermost open scope
+
+        Timer& timer(const char* name) {
+            for (Timer& t : timers) {
+                if (t.name == name) return t;
+            }
+            timers.push_back(Timer{name});
+            return timers.back();
+        }
+
+        Counter& counter(const char* name) {
+            for (Counter& c : counters) {
+                if (c.name == name) return c;
+            }
+            counters.push_back(Counter{name});
+            return counters.back();
+        }
+    };
+
+    /// @brief The calling thread's record, created on first use
+    static Thread& thread() {
+        thread_local Thread* self = nullptr;
+        if (!self) {
+            Profiler& p = instance();
+            std::lock_guard<std::mutex> lock(p.mutex);
+            p.threads.emplace_back(new Thread());
+            self = p.threads.back().get();
+            self->id = static_cast<int>(p.threads.size());
+        }
+        return *self;
+    }
+
+    /// @brief Nanoseconds since the profiler started
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - instance().origin).count();
+    }
+
+    static void count(const char* name, long long value) { thread().counter(name).value += value; }
+
+    /// @brief Clears the records of every thread
+    static void reset() {
+        Profiler& p = instance();
+        std::lock_guard<std::mutex> lock(p.mutex);
+        for (std::unique_ptr<Thread>& t : p.threads) {
+            t->timers.clear();
+            t->counters.clear();
+            t->events.clear();
+            t->droppedEvents = 0;
+        }
+    }
+
+    /// @brief Writes the summary: per scope and counter, the total and the per-thread values
+    static void writeSummary(const std::string& filename) {
+        Profiler& p = instance();
+        std::lock_guard<std::mutex> lock(p.mutex);
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return;
+        }
+        std::map<std::string, std::vector<std::pair<int, const Timer*>>> timers;
+        std::map<std::string, std::vector<std::pair<int, const Counter*>>> counters;
+        for (const std::unique_ptr<Thread>& t : p.threads) {
+            for (const Timer& timer : t->timers) timers[timer.name].push_back({t->id, &timer});
+            for (const Counter& counter : t->counters) counters[counter.name].push_back({t->id, &counter});
+        }
+        out << "{\n  \"threads\": " << p.threads.size() << ",\n  \"scopes\": {";
+        bool first = true;
+        for (const auto& entry : timers) {
+            long long calls = 0;
+            int64_t total = 0, self = 0, longest = 0;
+            for (const auto& item : entry.second) {
+                calls += item.second->calls;
+                total += item.second->totalNs;
+                self += item.second->selfNs;
+                longest = std::max(longest, item.second->maxNs);
+            }
+            out << (first ? "\n" : ",\n") << "    \"" << entry.first << "\": {\"calls\": " << calls << ", \"total_s\": " << total * 1e-9
+                << ", \"self_s\": " << self * 1e-9 << ", \"max_s\": " << longest * 1e-9 << ", \"per_thread\": {";
+            for (size_t k = 0; k < entry.second.size(); k++) {
+                out << (k ? ", " : "") << "\"" << entry.second[k].first << "\": {\"calls\": " << entry.second[k].second->calls
+                    << ", \"total_s\": " << entry.second[k].second->totalNs * 1e-9 << "}";
+            }
+            out << "}}";
+            first = false;
+        }
+        out << "\n  },\n  \"counters\": {";
+        first = true;
+        for (const auto& entry : counters) {
+            long long total = 0;
+            for (const auto& item : entry.second) total += item.second->value;
+            out << (first ? "\n" : ",\n") << "    \"" << entry.first << "\": {\"total\": " << total << ", \"per_thread\": {";
+            for (size_t k = 0; k < entry.second.size(); k++) {
+                out << (k ? ", " : "") << "\"" << entry.second[k].first << "\": " << entry.second[k].second->value;
+            }
+            out << "}}";
+            first = false;
+        }
+        out << "\n  }\n}\n";
+    }
+
+    /// @brief Writes the scopes as Chrome trace "complete" events (one track per thread)
+    static void writeTrace(const std::string& filename) {
+        Profiler& p = instance();
+        std::lock_guard<std::mutex> lock(p.mutex);
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return;
+        }
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const std::unique_ptr<Thread>& t : p.threads) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t->id
+                << ", \"args\": {\"name\": \"thread " << t->id << "\"}}";
+            first = false;
+            for (const Event& e : t->events) {
+                out << ",\n{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << t->id << ", \"ts\": " << e.startNs / 1000
+                    << "." << (e.startNs % 1000) / 100 << ", \"dur\": " << e.durationNs / 1000 << "." << (e.durationNs % 1000) / 100 << "}";
+            }
+            if (t->droppedEvents > 0) {
+                std::cerr << "Warning: " << t->droppedEvents << " trace events of thread " << t->id << " dropped" << std::endl;
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    /// @class Scope
+    /// @brief Times a block and records it on the calling thread
+    class Scope {
+    public:
+        Scope(const char* name) : name(name), owner(thread()), parent(owner.childNs), start(now()) {
+            owner.childNs = &children;
+        }
+
+        ~Scope() {
+            const int64_t duration = now() - start;
+            owner.childNs = parent;
+            if (parent) *parent += duration;
+            Timer& timer = owner.timer(name);
+            timer.calls++;
+            timer.totalNs += duration;
+            timer.selfNs += duration - children;
+            timer.maxNs = std::max(timer.maxNs, duration);
+            if (owner.events.size() < MAX_EVENTS) owner.events.push_back(Event{name, start, duration});
+            else owner.droppedEvents++;
+        }
+
+    private:
+        const char* name;
+        Thread& owner;
+        int64_t* parent;
+        int64_t start;
+        int64_t children = 0;
+    };
+
+private:
+    Profiler() : origin(std::chrono::steady_clock::now()) {}
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    std::chrono::steady_clock::time_point origin;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Thread>> threads;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(name, value) Profiler::count(name, static_cast<long long>(value))
+#define PROFILE_RESET() Profiler::reset()
+#define PROFILE_REPORT(summary, trace)                                  \
+    do {                                                                \
+        if (!std::string(summary).empty()) Profiler::writeSummary(summary); \
+        if (!std::string(trace).empty()) Profiler::writeTrace(trace);       \
+    } while (0)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(name, value) ((void)0)
+#define PROFILE_RESET() ((void)0)
+#define PROFILE_REPORT(summary, trace) ((void)0)
+
+#endif
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "Output.cpp"
+#include "MappedFile.cpp"
+#include "Profiler.cpp"
+
+/// @struct PyramidHeader
+/// @brief Fixed 256-byte header of a level-of-detail file (.lod, little-endian)
+/// @note Layout: header | records | per level, the int64 offset of each of its
+///       records | levels x PyramidLevelInfo table at `level_offset`. A record
+///       is float64 t_first, float64 t_last, then float32 min[columns],
+///       max[columns], mean[columns]. Level 0 is the full-resolution result
+///       file and is not repeated here; level k (1 to levels) covers
+///       `x_bin` points by `t_bin` recorded levels per cell.
+struct PyramidHeader {
+    char magic[8];          ///< "WESLOD1" followed by a NUL
+    uint32_t version;       ///< Format version (1)
+    uint32_t factor;        ///< Decimation factor between consecutive levels
+    char scheme[32];        ///< Scheme name, NUL padded
+    char bondary[32];       ///< Boundary set name, NUL padded
+    int64_t N;              ///< Values per full-resolution row
+    int64_t rows;           ///< Number of full-resolution rows
+    double dt;              ///< Time step size
+    double dx;              ///< Spatial step size
+    double x_min;           ///< x of the first value in a row
+    double CFL;             ///< Courant-Friedrichs-Lewy number
+    double u;               ///< Advection velocity
+    int64_t levels;         ///< Number of decimated levels
+    int64_t level_offset;   ///< Byte offset of the level table
+    char reserved[104];     ///< Zero
+};
+static_assert(sizeof(PyramidHeader) == 256, "PyramidHeader must stay 256 bytes");
+
+/// @struct PyramidLevelInfo
+/// @brief Shape of one decimated level
+struct PyramidLevelInfo {
+    int64_t columns;        ///< Cells per row
+    int64_t rows;           ///< Number of records
+    int64_t x_bin;          ///< Full-resolution points per cell (the last cell may hold fewer)
+    int64_t t_bin;          ///< Full-resolution levels per record (the last record may hold fewer)
+    int64_t index_offset;   ///< Byte offset of the rows x int64 record offsets
+};
+
+/// @brief Magic string identifying level-of-detail files
+static const char PYRAMID_MAGIC[8] = {'W', 'E', 'S', 'L', 'O', 'D', '1', '\0'};
+
+/// @class PyramidSink
+/// @brief Streams the levels of a run into a min/max/mean level-of-detail pyramid
+/// @note Level 1 merges `factor` recorded levels and `factor` points per cell;
+///       each further level merges `factor` x `factor` cells of the previous one.
+///       Once a level has at most `target` columns it is only decimated in time,
+///       and levels are added until both the columns and the bound on the
+///       recorded rows (steps + 1) fit in `target`. Min and max are rounded
+///       outwards to float32, so the stored envelope always contains the values.
+///       The pyramid is built in one pass with one partial row per level in
+///       memory; records are written as they complete.
+class PyramidSink : public RowSink {
+public:
+    /// @brief Constructor
+    /// @param filename The output file (conventionally with a .lod extension)
+    /// @param factor Decimation factor between levels (at least 2)
+    /// @param target Size at which an axis stops being decimated
+    PyramidSink(const std::string& filename, int factor = 4, int target = 256)
+        : filename(filename), factor(std::max(2, factor)), target(std::max(1, target)) {}
+
+    void begin(const RunInfo& info) override {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC));
+        header.version = 1;
+        header.factor = factor;
+        std::strncpy(header.scheme, info.scheme.c_str(), sizeof(header.scheme) - 1);
+        std::strncpy(header.bondary, info.bondary.c_str(), sizeof(header.bondary) - 1);
+        header.N = info.N;
+        header.dt = info.dt;
+        header.dx = info.dx;
+        header.x_min = info.x_min;
+        header.CFL = info.CFL;
+        header.u = info.u;
+        N = std::max(0, info.N);
+        rows = 0;
+
+        // Level shapes: decimate x while the previous level is wider than target, t always
+        levels.clear();
+        int64_t columns = N, xBin = 1, tBin = 1, rowBound = std::max(1, info.steps + 1);
+        while (columns > target || rowBound > target) {
+            Level level;
+            level.merge = columns > target ? factor : 1;
+            xBin *= level.merge;
+            tBin *= factor;
+            columns = (columns + level.merge - 1) / level.merge;
+            rowBound = (rowBound + factor - 1) / factor;
+            level.xBin = xBin;
+            level.tBin = tBin;
+            level.columns = static_cast<int>(columns);
+            level.reset();
+            levels.push_back(std::move(level));
+        }
+
+        out.open(filename, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        offset = sizeof(header);
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        if (!out.is_open() || levels.empty()) return;
+        PROFILE_SCOPE("lod");
+        rows++;
+        // Level 1 takes the row itself, as cells of one point
+        Level& first = levels[0];
+        const int count = std::min(n, N);
+        for (int c = 0; c < first.columns; c++) {
+            const int begin = c * first.merge;
+            const int end = std::min(count, begin + first.merge);
+            if (begin >= end) continue;
+            double low = row[begin], high = row[begin], sum = row[begin];
+            for (int i = begin + 1; i < end; i++) {
+                low = std::min(low, row[i]);
+                high = std::max(high, row[i]);
+                sum += row[i];
+            }
+            first.min[c] = std::min(first.min[c], low);
+            first.max[c] = std::max(first.max[c], high);
+            first.sum[c] += sum;
+            first.count[c] += end - begin;
+        }
+        close(0, t, t);
+    }
+
+    void end() override {
+        if (!out.is_open()) return;
+        for (size_t k = 0; k < levels.size(); k++) {
+            if (levels[k].merged > 0) emit(k);
+        }
+        std::vector<PyramidLevelInfo> table(levels.size());
+        for (size_t k = 0; k < levels.size(); k++) {
+            table[k].columns = levels[k].columns;
+            table[k].rows = static_cast<int64_t>(levels[k].offsets.size());
+            table[k].x_bin = levels[k].xBin;
+            table[k].t_bin = levels[k].tBin;
+            table[k].index_offset = offset;
+            out.write(reinterpret_cast<const char*>(levels[k].offsets.data()), levels[k].offsets.size() * sizeof(int64_t));
+            offset += static_cast<int64_t>(levels[k].offsets.size() * sizeof(int64_t));
+        }
+        header.rows = rows;
+        header.levels = static_cast<int64_t>(levels.size());
+        header.level_offset = offset;
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(PyramidLevelInfo));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!out) std::cerr << "Error writing file: " << filename << std::endl;
+        out.close();
+    }
+
+private:
+    struct Level {
+        int merge = 1;              ///< Columns of the previous level merged per cell
+        int columns = 0;
+        int64_t xBin = 1;
+        int64_t tBin = 1;
+        std::vector<double> min, max, sum;
+        std::vector<int64_t> count;
+        int merged = 0;             ///< Rows of the previous level in the partial row
+        double tFirst = 0, tLast = 0;
+        std::vector<int64_t> offsets;
+        std::vector<float> record;
+
+        void reset() {
+            min.assign(columns, std::numeric_limits<double>::infinity());
+            max.assign(columns, -std::numeric_limits<double>::infinity());
+            sum.assign(columns, 0.0);
+            count.assign(columns, 0);
+            merged = 0;
+        }
+    };
+
+    /// @brief Counts one more input row in level k, emitting the row when its bin is complete
+    void close(size_t k, double tFirst, double tLast) {
+        Level& level = levels[k];
+        if (level.merged == 0) level.tFirst = tFirst;
+        level.tLast = tLast;
+        if (++level.merged == factor) emit(k);
+    }
+
+    /// @brief Writes the partial row of level k and merges it into level k + 1
+    void emit(size_t k) {
+        Level& level = levels[k];
+        level.offsets.push_back(offset);
+        level.record.resize(3 * static_cast<size_t>(level.columns));
+        float* min = level.record.data();
+        float* max = min + level.columns;
+        float* mean = max + level.columns;
+        for (int c = 0; c < level.columns; c++) {
+            min[c] = down(level.min[c]);
+            max[c] = up(level.max[c]);
+            mean[c] = static_cast<float>(level.count[c] > 0 ? level.sum[c] / level.count[c] : 0.0);
+        }
+        out.write(reinterpret_cast<const char*>(&level.tFirst), sizeof(double));
+        out.write(reinterpret_cast<const char*>(&level.tLast), sizeof(double));
+        out.write(reinterpret_cast<const char*>(level.record.data()), level.record.size() * sizeof(float));
+        offset += static_cast<int64_t>(2 * sizeof(double) + level.record.size() * sizeof(float));
+
+        if (k + 1 < levels.size()) {
+            Level& next = levels[k + 1];
+            for (int c = 0; c < level.columns; c++) {
+                const int cell = c / next.merge;
+                next.min[cell] = std::min(next.min[cell], level.min[c]);
+                next.max[cell] = std::max(next.max[cell], level.max[c]);
+                next.sum[cell] += level.sum[c];
+                next.count[cell] += level.count[c];
+            }
+            const double tFirst = level.tFirst, tLast = level.tLast;
+            level.reset();
+            close(k + 1, tFirst, tLast);
+        } else {
+            level.reset();
+        }
+    }
+
+    /// @brief Largest float not above v
+    static float down(double v) {
+        float f = static_cast<float>(v);
+        if (static_cast<double>(f) > v) f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+        return f;
+    }
+
+    /// @brief Smallest float not below v
+    static float up(double v) {
+        float f = static_cast<float>(v);
+        if (static_cast<double>(f) < v) f = std::nextafter(f, std::numeric_limits<float>::infinity());
+        return f;
+    }
+
+    std::string filename;
+    int factor;
+    int target;
+    int N = 0;
+    int64_t rows = 0;
+    std::ofstream out;
+    PyramidHeader header;
+    std::vector<Level> levels;
+    int64_t offset = 0;
+};
+
+/// @class PyramidFile
+/// @brief Read-only, memory-mapped view of a level-of-detail file
+class PyramidFile {
+public:
+    PyramidFile() {}
+    PyramidFile(const PyramidFile&) = delete;
+    PyramidFile& operator=(const PyramidFile&) = delete;
+    ~PyramidFile() { close(); }
+
+    /// @brief Maps a level-of-detail file
+    /// @param filename The file to open
+    /// @return True on success; errors are reported on std::cerr
+    bool open(const std::string& filename) {
+        close();
+        if (!file.open(filename)) {
+            return false;
+        }
+        base = file.data();
+        length = file.size();
+        if (!validate()) {
+            std::cerr << "Error: " << filename << " is not a valid level-of-detail file" << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief Unmaps the file
+    void close() {
+        file.close();
+        base = nullptr;
+        length = 0;
+    }
+
+    const PyramidHeader& info() const { return *reinterpret_cast<const PyramidHeader*>(base); }
+
+    /// @brief Number of decimated levels (level 0, the full resolution, is the result file)
+    int levels() const { return static_cast<int>(info().levels); }
+
+    /// @brief Shape of level k (1 to levels())
+    PyramidLevelInfo level(int k) const {
+        PyramidLevelInfo value;
+        std::memcpy(&value, base + info().level_offset + (k - 1) * sizeof(PyramidLevelInfo), sizeof(value));
+        return value;
+    }
+
+    /// @brief Finest level with at most maxRows records between t0 and t1 and at most maxColumns cells
+    /// @return 0 when the full resolution fits, levels() when none does
+    int choose(int64_t maxRows, int64_t maxColumns, double t0, double t1) const {
+        if (levels() == 0) return 0;
+        for (int k = 0; k <= levels(); k++) {
+            const int64_t columns = k == 0 ? info().N : level(k).columns;
+            int64_t first = 0, count = 0;
+            if (k == 0) {
+                const int64_t bin = level(1).t_bin;
+                rows(1, t0, t1, first, count);
+                count *= bin; // Bound on the full-resolution rows of the range
+            } else {
+                rows(k, t0, t1, first, count);
+            }
+            if (columns <= maxColumns && count <= maxRows) return k;
+        }
+        return levels();
+    }
+
+    /// @brief Time range of record i of level k
+    void times(int k, int64_t i, double& tFirst, double& tLast) const {
+        const char* record = base + offsetOf(k, i);
+        std::memcpy(&tFirst, record, sizeof(double));
+        std::memcpy(&tLast, record + sizeof(double), sizeof(double));
+    }
+
+    /// @brief Records of level k overlapping [t0, t1]
+    /// @param first Receives the first record
+    /// @param count Receives the number of records
+    void rows(int k, double t0, double t1, int64_t& first, int64_t& count) const {
+        const int64_t total = level(k).rows;
+        // Records are in time order: binary search the first ending at or after t0 and the first starting after t1
+        int64_t lo = 0, hi = total;
+        while (lo < hi) {
+            const int64_t mid = (lo + hi) / 2;
+            double a, b;
+            times(k, mid, a, b);
+            if (b < t0) lo = mid + 1;
+            else hi = mid;
+        }
+        first = lo;
+        hi = total;
+        while (lo < hi) {
+            const int64_t mid = (lo + hi) / 2;
+            double a, b;
+            times(k, mid, a, b);
+            if (a <= t1) lo = mid + 1;
+            else hi = mid;
+        }
+        count = lo - first;
+    }
+
+    /// @brief Min, max and mean of record i of level k (columns values each)
+    const float* min(int k, int64_t i) const { return reinterpret_cast<const float*>(base + offsetOf(k, i) + 2 * sizeof(double)); }
+    const float* max(int k, int64_t i) const { return min(k, i) + level(k).columns; }
+    const float* mean(int k, int64_t i) const { return min(k, i) + 2 * level(k).columns; }
+
+    /// @brief x at the centre of cell c of level k
+    double x(int k, int64_t c) const {
+        const PyramidLevelInfo shape = level(k);
+        const int64_t first = c * shape.x_bin;
+        const int64_t last = std::min(info().N, first + shape.x_bin) - 1;
+        return info().x_min + 0.5 * (first + last) * info().dx;
+    }
+
+private:
+    int64_t offsetOf(int k, int64_t i) const {
+        int64_t value;
+        std::memcpy(&value, base + level(k).index_offset + i * sizeof(int64_t), sizeof(value));
+        return value;
+    }
+
+    bool validate() const {
+        if (length < sizeof(PyramidHeader)) return false;
+        const PyramidHeader& h = info();
+        if (std::memcmp(h.magic, PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC)) != 0 || h.version != 1) return false;
+        if (h.N < 0 || h.rows < 0 || h.levels < 0 || h.level_offset < static_cast<int64_t>(sizeof(PyramidHeader))) return false;
+        if (static_cast<size_t>(h.level_offset + h.levels * sizeof(PyramidLevelInfo)) > length) return false;
+        for (int k = 1; k <= h.levels; k++) {
+            const PyramidLevelInfo shape = level(k);
+            if (shape.columns < 0 || shape.rows < 0 || shape.index_offset < static_cast<int64_t>(sizeof(PyramidHeader)) ||
+                shape.index_offset + shape.rows * static_cast<int64_t>(sizeof(int64_t)) > h.level_offset) {
+                return false;
+            }
+            const int64_t record = 2 * sizeof(double) + 3 * shape.columns * sizeof(float);
+            for (int64_t i = 0; i < shape.rows; i++) {
+                const int64_t start = offsetOf(k, i);
+                if (start < static_cast<int64_t>(sizeof(PyramidHeader)) || start + record > h.level_offset) return false;
+            }
+        }
+        return true;
+    }
+
+    MappedFile file;
+    const char* base = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "Schemes.cpp"
+#include "Output.cpp"
+#include "SchemeEngine.cpp"
+#include "Norms.cpp"
+#include "Profiler.cpp"
+
+/// @struct Refinement
+/// @brief Settings of the block-structured mesh refinement of the explicit schemes
+/// @note Level l + 1 has `ratio` times the points of level l over the patches it
+///       covers and takes `ratio` steps per step of level l (subcycling), so every
+///       level runs at the same Courant number. Cells of level l are flagged when the
+///       indicator crosses `threshold`, grown by the distance the solution advects
+///       before the next regrid, and rounded out to whole blocks of `block` cells.
+struct Refinement {
+    /// @enum Indicator
+    /// @brief What flags a cell for refinement
+    enum Indicator {
+        Gradient, ///< Jump |f[i + 1] - f[i]| across the cell
+        ErrorNorm ///< Norm over a block of f[i] - (f[i - 1] + f[i + 1]) / 2, the error of the next coarser grid
+    };
+
+    int levels = 0;           ///< Refined levels above the base grid (0: uniform solve)
+    int ratio = 2;            ///< Refinement ratio in space and time between two levels
+    Indicator indicator = ErrorNorm; ///< Refinement criterion
+    double threshold = 1e-5;  ///< Indicator value above which a cell (Gradient) or a block (ErrorNorm) is refined
+    Norms::NormType norm = Norms::NormType::LInf; ///< Norm of the ErrorNorm indicator (Norms::calcNorm)
+    int block = 8;            ///< Cells per block; patches are unions of whole blocks
+    int regridEvery = 8;      ///< Steps of a level between two regrids of the finer levels
+
+    /// @brief Ratio between the base spacing and the spacing of the finest level
+    int scale() const {
+        int s = 1;
+        for (int l = 0; l < levels; l++) s *= ratio;
+        return s;
+    }
+
+    /// @brief Points of the finest level's grid over the base grid of N points
+    int outputPoints(int N) const {
+        return (N - 1) * scale() + 1;
+    }
+};
+
+/// @struct RefinementStats
+/// @brief Work of a refined solve
+struct RefinementStats {
+    long long pointsUpdated = 0; ///< Point updates over every level and substep
+    long long peakPoints = 0;    ///< Largest number of points held by all the levels at once
+    int regrids = 0;             ///< Regrids of any level
+    std::vector<long long> levelUpdates; ///< Point updates of each level
+};
+
+/// @class RefinedEngine
+/// @brief Berger-Oliger stepping of an explicit stencil on a hierarchy of refined patches
+/// @note Level 0 is the base grid of the run and steps exactly like SchemeEngine.
+///       Each patch of level l + 1 covers an interval of points of one patch of level
+///       l, with GHOST extra points on each side. A step of level l is followed by
+///       `ratio` steps of level l + 1, whose ghost points are interpolated from level l,
+///       linearly in space and in time between the values before and after its step;
+///       the fine values are then injected into the level l points they coincide with.
+///       Every `regridEvery` steps of level l the finer levels are rebuilt from the
+///       flags of level l; new points copy the old patches where they overlap and are
+///       interpolated from level l elsewhere. Recorded levels are written on the grid
+///       of the finest level, unrefined regions being interpolated linearly.
+template <class Stencil>
+class RefinedEngine {
+public:
+    /// @brief Ghost points on each side of a patch (the Richtmyer prediction at the first ghost reads the second)
+    static const int GHOST = 2;
+
+    /// @brief Constructor
+    /// @param run Runtime parameters of the base grid (N, x_min, dx, dt, steps, k, schedule, t0_function)
+    /// @param settings Levels, ratio, indicator and regrid interval
+    RefinedEngine(const EngineRun& run, const Refinement& settings) : run(run), settings(settings) {
+        ratio = std::max(2, settings.ratio);
+        this->settings.block = std::max(1, settings.block);
+        this->settings.regridEvery = std::max(1, settings.regridEvery);
+        margin = (GHOST + ratio - 1) / ratio + 1;
+        buffer = static_cast<int>(std::ceil(std::fabs(run.k.c) * this->settings.regridEvery)) + 1;
+        Stencil::range(run.N, begin, end);
+        end = std::max(begin, end);
+
+        levels.resize(std::max(0, settings.levels) + 1);
+        levels[0].dx = run.dx;
+        levels[0].dt = run.dt;
+        levels[0].k = run.k;
+        for (size_t l = 1; l < levels.size(); l++) {
+            levels[l].dx = levels[l - 1].dx / ratio;
+            levels[l].dt = levels[l - 1].dt / ratio;
+            levels[l].k = SchemeCoefficients::make(levels[l].dx, levels[l].dt, run.k.u);
+        }
+        outputScale = 1;
+        for (size_t l = 1; l < levels.size(); l++) outputScale *= ratio;
+        stats.levelUpdates.assign(levels.size(), 0);
+    }
+
+    /// @brief Evaluates the initial condition on every level, steps and streams the recorded levels
+    /// @param sink Receives the recorded levels on the finest grid (begin/end are the caller's job)
+    void solve(RowSink& sink) {
+        initialise();
+        const int points = (run.N - 1) * outputScale + 1;
+        std::vector<double> row(points);
+        for (int level = 0; level <= run.steps; level++) {
+            if (level > 0) advance(0);
+            if (run.schedule->at(level)) {
+                compose(row);
+                sink.write(level, level * run.dt, row.data(), points);
+            }
+        }
+    }
+
+    /// @brief Work of the solve
+    const RefinementStats& statistics() const { return stats; }
+
+private:
+    /// @struct Patch
+    /// @brief Interval of points of one level with its rows
+    struct Patch {
+        int lo;     ///< First point, in indices of the patch's level
+        int hi;     ///< One past the last point
+        int parent; ///< Index of the enclosing patch one level down
+        std::vector<double> a, b, half; ///< Rows of hi - lo + 2 * GHOST values
+        bool flipped = false;           ///< Whether b holds the current values
+        std::vector<double> leftOld, rightOld; ///< Parent values under the ghost points before the parent's step
+
+        int size() const { return hi - lo; }
+        double* row() { return (flipped ? b.data() : a.data()) + GHOST; }
+        double& at(int i) { return row()[i - lo]; }
+    };
+
+    /// @struct Level
+    /// @brief Spacing, step and patches of one level
+    struct Level {
+        double dx;
+        double dt;
+        SchemeCoefficients k;
+        std::vector<Patch> patches;
+        int steps = 0; ///< Steps since the last regrid of the finer levels
+    };
+
+    static int floorDiv(int a, int b) {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    }
+
+    /// @brief Allocates the rows of a patch
+    static void allocate(Patch& p) {
+        p.a.assign(p.size() + 2 * GHOST, 0.0);
+        p.b = p.a;
+        p.half = p.a;
+    }
+
+    /// @brief Value at point j of a level from the points of the level below it
+    /// @param values Values of the coarser points base, base + 1, ...
+    double interpolate(const double* values, int base, int j) const {
+        const int J = floorDiv(j, ratio);
+        const double w = static_cast<double>(j - J * ratio) / ratio;
+        const double* v = values + (J - base);
+        return (w == 0) ? v[0] : v[0] + w * (v[1] - v[0]);
+    }
+
+    /// @brief Base grid from the initial condition, then the finer levels from the flags
+    void initialise() {
+        Patch base;
+        base.lo = 0;
+        base.hi = run.N;
+        base.parent = -1;
+        allocate(base);
+        for (int i = 0; i < run.N; i++) {
+            double x = run.x_min + i * run.dx;
+            base.a[GHOST + i] = run.t0_function(x);
+        }
+        // Points outside the update range keep their initial value in both rows (and in
+        // the Richtmyer prediction row, as in SchemeEngine)
+        base.b = base.a;
+        base.half = base.a;
+        levels[0].patches.push_back(std::move(base));
+        if (levels.size() > 1) regrid(0, true);
+        countPoints();
+    }
+
+    /// @brief One step of level l, its subcycled finer levels and their regrids
+    void advance(int l) {
+        Level& level = levels[l];
+        const bool refined = l + 1 < static_cast<int>(levels.size()) && !levels[l + 1].patches.empty();
+        if (refined) snapshot(l);
+        for (Patch& p : level.patches) step(l, p);
+
+        if (refined) {
+            for (int s = 0; s < ratio; s++) {
+                fillGhosts(l + 1, static_cast<double>(s) / ratio);
+                advance(l + 1);
+            }
+            restrict(l + 1);
+        }
+        if (l + 1 < static_cast<int>(levels.size()) && ++level.steps % settings.regridEvery == 0) {
+            regrid(l, false);
+            countPoints();
+        }
+    }
+
+    /// @brief Advances one patch by one step of its level
+    void step(int l, Patch& p) {
+        const Level& level = levels[l];
+        double* current = p.row();
+        double* spare = (p.flipped ? p.a.data() : p.b.data()) + GHOST;
+        double* half = p.half.data() + GHOST;
+        int lo = 0, hi = p.size();
+        if (l == 0) {
+            lo = begin;
+            hi = end;
+        } else if constexpr (std::is_same<Stencil, RichtmyerStencil>::value) {
+            // The correction at the patch ends reads the prediction at the first ghost points
+            half[lo - 1] = Row_Schemes::Richtmyer_prediction_point(level.k, current, lo - 1);
+            half[hi] = Row_Schemes::Richtmyer_prediction_point(level.k, current, hi);
+        }
+        Stencil::step(level.k, current, spare, half, lo, hi);
+        p.flipped = (current == p.b.data() + GHOST);
+        stats.pointsUpdated += hi - lo;
+        stats.levelUpdates[l] += hi - lo;
+    }
+
+    /// @brief Keeps the level l values under the ghost points of level l + 1 before level l steps
+    void snapshot(int l) {
+        for (Patch& c : levels[l + 1].patches) {
+            Patch& P = levels[l].patches[c.parent];
+            const int left = c.lo / ratio - margin;
+            const int right = (c.hi - 1) / ratio;
+            c.leftOld.assign(&P.at(left), &P.at(left) + margin + 1);
+            c.rightOld.assign(&P.at(right), &P.at(right) + margin + 1);
+        }
+    }
+
+    /// @brief Ghost points of level l at the fraction alpha of the step of level l - 1
+    void fillGhosts(int l, double alpha) {
+        for (Patch& c : levels[l].patches) {
+            Patch& P = levels[l - 1].patches[c.parent];
+            const int left = c.lo / ratio - margin;
+            const int right = (c.hi - 1) / ratio;
+            for (int j = c.lo - GHOST; j < c.lo; j++) {
+                c.at(j) = (1 - alpha) * interpolate(c.leftOld.data(), left, j) + alpha * interpolate(&P.at(left), left, j);
+            }
+            for (int j = c.hi; j < c.hi + GHOST; j++) {
+                c.at(j) = (1 - alpha) * interpolate(c.rightOld.data(), right, j) + alpha * interpolate(&P.at(right), right, j);
+            }
+        }
+    }
+
+    /// @brief Injects level l into the points of level l - 1 it covers
+    void restrict(int l) {
+        for (Patch& c : levels[l].patches) {
+            Patch& P = levels[l - 1].patches[c.parent];
+            for (int J = c.lo / ratio; J <= (c.hi - 1) / ratio; J++) {
+                P.at(J) = c.at(J * ratio);
+            }
+        }
+    }
+
+    /// @brief Intervals of points of level l to refine inside patch P, in level l indices
+    std::vector<std::pair<int, int>> flag(int l, Patch& P) {
+        const int n = P.size();
+        const double* f = &P.at(P.lo);
+        std::vector<char> cells(std::max(0, n - 1), 0);
+        if (settings.indicator == Refinement::Gradient) {
+            for (int i = 0; i + 1 < n; i++) {
+                cells[i] = std::fabs(f[i + 1] - f[i]) > settings.threshold;
+            }
+        } else {
+            // Blocks aligned on the level's cell indices, points of the block with both neighbours in P
+            std::vector<long double> error;
+            const int first = floorDiv(P.lo, settings.block) * settings.block;
+            for (int b0 = first; b0 < P.hi - 1; b0 += settings.block) {
+                const int lo = std::max(b0, P.lo + 1), hi = std::min(b0 + settings.block, P.hi - 1);
+                if (hi <= lo) continue;
+                error.clear();
+                for (int i = lo; i < hi; i++) {
+                    const int k = i - P.lo;
+                    error.push_back(f[k] - 0.5 * (f[k - 1] + f[k + 1]));
+                }
+                if (Norms::calcNorm(error, settings.norm) > settings.threshold) {
+                    for (int i = std::max(b0, P.lo); i < std::min(b0 + settings.block, P.hi - 1); i++) cells[i - P.lo] = 1;
+                }
+            }
+        }
+
+        // Runs of flagged cells, grown by the advection between regrids, rounded out to blocks and merged
+        std::vector<std::pair<int, int>> intervals;
+        const int block = settings.block;
+        for (int i = 0; i < n - 1; i++) {
+            if (!cells[i]) continue;
+            int j = i;
+            while (j + 1 < n - 1 && cells[j + 1]) j++;
+            int lo = P.lo + i - buffer;
+            int hi = P.lo + j + 1 + buffer;
+            lo = floorDiv(lo, block) * block;
+            hi = -floorDiv(-hi, block) * block;
+            if (!intervals.empty() && lo <= intervals.back().second) {
+                intervals.back().second = std::max(intervals.back().second, hi);
+            } else {
+                intervals.push_back(std::make_pair(lo, hi));
+            }
+            i = j;
+        }
+
+        // Room for the ghost points of the finer level and their interpolation inside P
+        const int low = ((l == 0) ? std::max(P.lo, begin) : P.lo) + margin;
+        const int high = ((l == 0) ? std::min(P.hi, end) - 1 : P.hi - 1) - margin;
+        std::vector<std::pair<int, int>> clipped;
+        for (const std::pair<int, int>& interval : intervals) {
+            const int lo = std::max(interval.first, low);
+            const int hi = std::min(interval.second, high);
+            if (hi > lo) clipped.push_back(std::make_pair(lo, hi));
+        }
+        return clipped;
+    }
+
+    /// @brief Rebuilds level l + 1 from the flags of level l, then the levels above it
+    /// @param initial Fill the new patches from the initial condition
+    void regrid(int l, bool initial) {
+        PROFILE_SCOPE("regrid");
+        Level& coarse = levels[l];
+        Level& fine = levels[l + 1];
+        std::vector<Patch> patches;
+        for (size_t pi = 0; pi < coarse.patches.size(); pi++) {
+            Patch& P = coarse.patches[pi];
+            for (const std::pair<int, int>& interval : flag(l, P)) {
+                Patch c;
+                c.lo = interval.first * ratio;
+                c.hi = interval.second * ratio + 1;
+                c.parent = static_cast<int>(pi);
+                allocate(c);
+                for (int j = c.lo; j < c.hi; j++) {
+                    double value;
+                    if (initial) {
+                        double x = run.x_min + j * fine.dx;
+                        value = run.t0_function(x);
+                    } else {
+                        Patch* old = nullptr;
+                        for (Patch& candidate : fine.patches) {
+                            if (j >= candidate.lo && j < candidate.hi) old = &candidate;
+                        }
+                        const int J = floorDiv(j, ratio);
+                        value = old ? old->at(j) : interpolate(&P.at(J), J, j);
+                    }
+                    c.a[GHOST + j - c.lo] = value;
+                }
+                patches.push_back(std::move(c));
+            }
+        }
+        fine.patches.swap(patches);
+        fine.steps = 0;
+        stats.regrids++;
+        if (l + 2 < static_cast<int>(levels.size())) regrid(l + 1, initial);
+    }
+
+    /// @brief Updates the peak number of points held by the hierarchy
+    void countPoints() {
+        long long points = 0;
+        for (const Level& level : levels) {
+            for (const Patch& p : level.patches) points += p.size();
+        }
+        stats.peakPoints = std::max(stats.peakPoints, points);
+    }
+
+    /// @brief Composite solution on the finest grid: each level overwrites the one below
+    void compose(std::vector<double>& row) {
+        PROFILE_SCOPE("composite_row");
+        int spacing = outputScale;
+        for (Level& level : levels) {
+            for (Patch& p : level.patches) {
+                const double* f = &p.at(p.lo);
+                double* out = row.data() + static_cast<size_t>(p.lo) * spacing;
+                for (int i = 0; i + 1 < p.size(); i++) {
+                    const double a = f[i], d = f[i + 1] - f[i];
+                    out[0] = a;
+                    for (int q = 1; q < spacing; q++) out[q] = a + d * (static_cast<double>(q) / spacing);
+                    out += spacing;
+                }
+                out[0] = f[p.size() - 1];
+            }
+            spacing /= ratio;
+        }
+    }
+
+    EngineRun run;
+    Refinement settings;
+    int ratio;
+    int margin;      ///< Points of level l between a patch of level l + 1 and the edge of its parent
+    int buffer;      ///< Cells a flag grows by: the advection over regridEvery steps, plus one
+    int begin, end;  ///< Update range of the base grid
+    int outputScale; ///< Spacing of the base grid in points of the finest level
+    std::vector<Level> levels;
+    RefinementStats stats;
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+/// @struct ResampleGrid
+/// @brief Uniform grid x_i = x_min + i * dx, i in [0, N)
+struct ResampleGrid {
+    double x_min;  ///< x of the first point
+    double dx;     ///< Spacing
+    int N;         ///< Number of points
+};
+
+/// @class ResamplePlan
+/// @brief Precomputed mapping of a row on one grid onto another grid
+/// @note Every destination point is a weighted sum of `width` consecutive source
+///       points starting at first[i]; the indices and weights are computed once and
+///       the plan is then applied to any number of rows. Points with fewer taps
+///       (restriction at the edges) are padded with zero weights so the inner loop
+///       has a fixed trip count. Destination points outside the source grid take the
+///       nearest source values (no extrapolation).
+class ResamplePlan {
+public:
+    /// @enum Method
+    /// @brief Interpolation or restriction rule
+    enum class Method {
+        Linear,   ///< Two-point linear interpolation
+        Cubic,    ///< Four-point cubic Lagrange interpolation
+        Lagrange, ///< Lagrange interpolation of a given order (order + 1 points)
+        Average   ///< Restriction: mean of the source cells overlapping each destination cell
+    };
+
+    ResamplePlan() {}
+
+    /// @brief Plan between two uniform grids (ratios need not be integers)
+    /// @param method The rule
+    /// @param from The source grid
+    /// @param to The destination grid
+    /// @param order Order of Method::Lagrange (1 to 7)
+    static ResamplePlan make(Method method, const ResampleGrid& from, const ResampleGrid& to, int order = 3) {
+        ResamplePlan plan;
+        plan.srcN = from.N;
+        plan.dstN = to.N;
+        if (from.N <= 0 || to.N <= 0) return plan;
+
+        // Destination positions in source index units
+        const double scale = to.dx / from.dx;
+        const double offset = (to.x_min - from.x_min) / from.dx;
+        switch (method) {
+        case Method::Linear: plan.buildLagrange(1, scale, offset); break;
+        case Method::Cubic: plan.buildLagrange(3, scale, offset); break;
+        case Method::Lagrange: plan.buildLagrange(std::max(1, std::min(order, 7)), scale, offset); break;
+        case Method::Average: plan.buildAverage(scale, offset); break;
+        }
+        return plan;
+    }
+
+    /// @brief Plan mapping the end points of a row of n points onto those of a row of m points
+    /// @note Same positions as Norms::interpolate: destination i sits at i * (n - 1) / (m - 1)
+    static ResamplePlan make(Method method, int n, int m, int order = 3) {
+        ResampleGrid from = {0.0, 1.0, n};
+        ResampleGrid to = {0.0, (m > 1) ? static_cast<double>(n - 1) / (m - 1) : 1.0, m};
+        return make(method, from, to, order);
+    }
+
+    int sourceSize() const { return srcN; }
+    int size() const { return dstN; }
+    int taps() const { return width; }
+
+    /// @brief Resamples one row
+    /// @param src The srcN source values
+    /// @param dst Receives the dstN resampled values
+    void apply(const double* src, double* dst) const {
+        applyRows(src, 0, dst, 0, 1);
+    }
+
+    /// @brief Resamples one row
+    std::vector<double> apply(const std::vector<double>& src) const {
+        std::vector<double> dst(dstN);
+        apply(src.data(), dst.data());
+        return dst;
+    }
+
+    /// @brief Resamples a batch of rows
+    /// @param src First source row
+    /// @param srcStride Distance between source rows (elements)
+    /// @param dst First destination row
+    /// @param dstStride Distance between destination rows (elements)
+    /// @param rows Number of rows
+    /// @note Rows are processed four at a time so the indices and weights of a
+    ///       destination point are loaded once per block of rows.
+    void applyRows(const double* src, size_t srcStride, double* dst, size_t dstStride, size_t rows) const {
+        switch (width) {
+        case 2: applyFixed<2>(src, srcStride, dst, dstStride, rows); break;
+        case 3: applyFixed<3>(src, srcStride, dst, dstStride, rows); break;
+        case 4: applyFixed<4>(src, srcStride, dst, dstStride, rows); break;
+        case 5: applyFixed<5>(src, srcStride, dst, dstStride, rows); break;
+        case 6: applyFixed<6>(src, srcStride, dst, dstStride, rows); break;
+        case 8: applyFixed<8>(src, srcStride, dst, dstStride, rows); break;
+        default: applyAny(src, srcStride, dst, dstStride, rows); break;
+        }
+    }
+
+private:
+    void resize(int taps) {
+        width = taps;
+        first.assign(dstN, 0);
+        weights.assign(static_cast<size_t>(dstN) * width, 0.0);
+    }
+
+    /// @brief Lagrange basis of `order` on order + 1 points around each position
+    void buildLagrange(int order, double scale, double offset) {
+        const int points = std::min(order + 1, srcN);
+        resize(points);
+        for (int i = 0; i < dstN; i++) {
+            double s = std::min(std::max(offset + i * scale, 0.0), static_cast<double>(srcN - 1));
+            // Stencil centred on s: floor(s) - (points - 1) / 2 ... , kept inside the grid
+            int start = static_cast<int>(std::floor(s)) - (points - 1) / 2;
+            start = std::max(0, std::min(start, srcN - points));
+            first[i] = start;
+            double* w = &weights[static_cast<size_t>(i) * width];
+            if (points == 1) {
+                w[0] = 1;
+                continue;
+            }
+            if (points == 2) {
+                // Same weights as Norms::interpolate, in double
+                double weight = s - start;
+                w[0] = 1 - weight;
+                w[1] = weight;
+                continue;
+            }
+            for (int k = 0; k < points; k++) {
+                double l = 1;
+                for (int j = 0; j < points; j++) {
+                    if (j != k) l *= (s - (start + j)) / static_cast<double>(k - j);
+                }
+                w[k] = l;
+            }
+        }
+    }
+
+    /// @brief Overlap weights of the source cells [j - 1/2, j + 1/2] with each destination cell
+    void buildAverage(double scale, double offset) {
+        const double half = 0.5 * std::max(scale, 1.0);
+        resize(std::min(srcN, static_cast<int>(std::ceil(2 * half)) + 2));
+        for (int i = 0; i < dstN; i++) {
+            double center = offset + i * scale;
+            double lo = std::max(center - half, -0.5);
+            double hi = std::min(center + half, srcN - 0.5);
+            if (hi <= lo) {
+                // Cell outside the source grid: nearest point
+                int j = (center < 0) ? 0 : srcN - 1;
+                first[i] = std::max(0, std::min(j, srcN - width));
+                weights[static_cast<size_t>(i) * width + (j - first[i])] = 1;
+                continue;
+            }
+            int j0 = static_cast<int>(std::floor(lo + 0.5));
+            int j1 = std::min(srcN - 1, static_cast<int>(std::ceil(hi - 0.5)));
+            int start = std::max(0, std::min(j0, srcN - width));
+            first[i] = start;
+            double* w = &weights[static_cast<size_t>(i) * width];
+            double total = 0;
+            for (int j = j0; j <= j1; j++) {
+                double overlap = std::min(hi, j + 0.5) - std::max(lo, j - 0.5);
+                if (overlap > 0) {
+                    w[j - start] = overlap;
+                    total += overlap;
+                }
+            }
+            for (int k = 0; k < width; k++) w[k] /= total;
+        }
+    }
+
+    template <int W>
+    void applyFixed(const double* src, size_t srcStride, double* dst, size_t dstStride, size_t rows) const {
+        const int* idx = first.data();
+        const double* wt = weights.data();
+        size_t r = 0;
+        for (; r + 4 <= rows; r += 4) {
+            const double* s0 = src + r * srcStride;
+            const double* s1 = s0 + srcStride;
+            const double* s2 = s1 + srcStride;
+            const double* s3 = s2 + srcStride;
+            double* d0 = dst + r * dstStride;
+            double* d1 = d0 + dstStride;
+            double* d2 = d1 + dstStride;
+            double* d3 = d2 + dstStride;
+            for (int i = 0; i < dstN; i++) {
+                const int j = idx[i];
+                const double* w = wt + static_cast<size_t>(i) * W;
+                double a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+                for (int k = 0; k < W; k++) {
+                    a0 += w[k] * s0[j + k];
+                    a1 += w[k] * s1[j + k];
+                    a2 += w[k] * s2[j + k];
+                    a3 += w[k] * s3[j + k];
+                }
+                d0[i] = a0;
+                d1[i] = a1;
+                d2[i] = a2;
+                d3[i] = a3;
+            }
+        }
+        for (; r < rows; r++) {
+            const double* s = src + r * srcStride;
+            double* d = dst + r * dstStride;
+            for (int i = 0; i < dstN; i++) {
+                const double* w = wt + static_cast<size_t>(i) * W;
+                double a = 0;
+                for (int k = 0; k < W; k++) a += w[k] * s[idx[i] + k];
+                d[i] = a;
+            }
+        }
+    }
+
+    void applyAny(const double* src, size_t srcStride, double* dst, size_t dstStride, size_t rows) const {
+        for (size_t r = 0; r < rows; r++) {
+            const double* s = src + r * srcStride;
+            double* d = dst + r * dstStride;
+            for (int i = 0; i < dstN; i++) {
+                const double* w = &weights[static_cast<size_t>(i) * width];
+                double a = 0;
+                for (int k = 0; k < width; k++) a += w[k] * s[first[i] + k];
+                d[i] = a;
+            }
+        }
+    }
+
+    int srcN = 0;
+    int dstN = 0;
+    int width = 0;
+    std::vector<int> first;       ///< First source index of each destination point
+    std::vector<double> weights;  ///< dstN x width weights, row-major
+};
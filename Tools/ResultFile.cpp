@@ -0,0 +1,210 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+#include "Output.cpp"
+#include "MappedFile.cpp"
+#include "Profiler.cpp"
+
+/// @struct ResultHeader
+/// @brief Fixed 256-byte header of a binary result file (.wes, little-endian)
+/// @note Layout: header | rows x N values (row-major, float64 or float32) |
+///       rows x (int64 level, float64 t) table. The data block starts at
+///       `data_offset`, which is 64-byte aligned so it can be mapped directly.
+struct ResultHeader {
+    char magic[8];          ///< "WESRES1" followed by a NUL
+    uint32_t version;       ///< Format version (1)
+    uint32_t value_size;    ///< 8 for float64 values, 4 for float32
+    char scheme[32];        ///< Scheme name, NUL padded
+    char bondary[32];       ///< Boundary set name, NUL padded
+    int64_t N;              ///< Values per row
+    int64_t rows;           ///< Number of stored time levels
+    double dt;              ///< Time step size
+    double dx;              ///< Spatial step size
+    double x_min;           ///< x of the first value in a row
+    double CFL;             ///< Courant-Friedrichs-Lewy number
+    double u;               ///< Advection velocity
+    int64_t data_offset;    ///< Byte offset of the value block
+    int64_t table_offset;   ///< Byte offset of the (level, t) table
+    char reserved[104];     ///< Zero
+};
+static_assert(sizeof(ResultHeader) == 256, "ResultHeader must stay 256 bytes");
+
+/// @brief Magic string identifying binary result files
+static const char RESULT_MAGIC[8] = {'W', 'E', 'S', 'R', 'E', 'S', '1', '\0'};
+
+/// @class BinarySink
+/// @brief Streams levels to a binary columnar result file
+class BinarySink : public RowSink {
+public:
+    /// @brief Constructor
+    /// @param filename The output file (conventionally with a .wes extension)
+    /// @param float32 Store values as float32 instead of float64
+    BinarySink(const std::string& filename, bool float32 = false) : filename(filename), float32(float32) {}
+
+    void begin(const RunInfo& info) override {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, RESULT_MAGIC, sizeof(RESULT_MAGIC));
+        header.version = 1;
+        header.value_size = float32 ? 4 : 8;
+        std::strncpy(header.scheme, info.scheme.c_str(), sizeof(header.scheme) - 1);
+        std::strncpy(header.bondary, info.bondary.c_str(), sizeof(header.bondary) - 1);
+        header.N = info.N;
+        header.dt = info.dt;
+        header.dx = info.dx;
+        header.x_min = info.x_min;
+        header.CFL = info.CFL;
+        header.u = info.u;
+        header.data_offset = sizeof(ResultHeader);
+        levels.clear();
+        times.clear();
+
+        out.open(filename, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    void write(int level, double t, const double* row, int n) override {
+        if (!out.is_open()) return;
+        PROFILE_SCOPE("file_write");
+        PROFILE_COUNT("bytes_written", static_cast<long long>(n) * (float32 ? 4 : 8));
+        if (float32) {
+            buffer.resize(n);
+            for (int j = 0; j < n; j++) {
+                buffer[j] = static_cast<float>(row[j]);
+            }
+            out.write(reinterpret_cast<const char*>(buffer.data()), n * sizeof(float));
+        } else {
+            out.write(reinterpret_cast<const char*>(row), n * sizeof(double));
+        }
+        levels.push_back(level);
+        times.push_back(t);
+    }
+
+    void end() override {
+        if (!out.is_open()) return;
+        header.rows = static_cast<int64_t>(levels.size());
+        header.table_offset = header.data_offset + header.rows * header.N * header.value_size;
+        for (size_t i = 0; i < levels.size(); i++) {
+            out.write(reinterpret_cast<const char*>(&levels[i]), sizeof(int64_t));
+            out.write(reinterpret_cast<const char*>(&times[i]), sizeof(double));
+        }
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+    }
+
+private:
+    std::string filename;
+    bool float32;
+    std::ofstream out;
+    ResultHeader header;
+    std::vector<int64_t> levels;
+    std::vector<double> times;
+    std::vector<float> buffer;
+};
+
+/// @class ResultFile
+/// @brief Read-only, memory-mapped view of a binary result file
+class ResultFile {
+public:
+    ResultFile() {}
+    ResultFile(const ResultFile&) = delete;
+    ResultFile& operator=(const ResultFile&) = delete;
+    ~ResultFile() { close(); }
+
+    /// @brief Maps a result file
+    /// @param filename The file to open
+    /// @return True on success; errors are reported on std::cerr
+    bool open(const std::string& filename) {
+        if (!file.open(filename)) {
+            return false;
+        }
+        base = file.data();
+        length = file.size();
+        if (!validate()) {
+            std::cerr << "Error: " << filename << " is not a valid result file" << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief Unmaps the file
+    void close() {
+        file.close();
+        base = nullptr;
+        length = 0;
+    }
+
+    const ResultHeader& info() const { return *reinterpret_cast<const ResultHeader*>(base); }
+    int64_t rows() const { return info().rows; }
+    int64_t N() const { return info().N; }
+    bool isFloat32() const { return info().value_size == 4; }
+
+    /// @brief x coordinate of column j
+    double x(int64_t j) const { return info().x_min + j * info().dx; }
+
+    /// @brief Time level index of row i
+    int64_t level(int64_t i) const {
+        int64_t value;
+        std::memcpy(&value, base + info().table_offset + i * 16, sizeof(value));
+        return value;
+    }
+
+    /// @brief Time of row i
+    double t(int64_t i) const {
+        double value;
+        std::memcpy(&value, base + info().table_offset + i * 16 + 8, sizeof(value));
+        return value;
+    }
+
+    /// @brief Direct pointer to a float64 row (nullptr for float32 files)
+    const double* row(int64_t i) const {
+        if (isFloat32()) return nullptr;
+        return reinterpret_cast<const double*>(base + info().data_offset) + i * N();
+    }
+
+    /// @brief Direct pointer to a float32 row (nullptr for float64 files)
+    const float* rowFloat32(int64_t i) const {
+        if (!isFloat32()) return nullptr;
+        return reinterpret_cast<const float*>(base + info().data_offset) + i * N();
+    }
+
+    /// @brief Value at row i, column j whatever the stored precision
+    double value(int64_t i, int64_t j) const {
+        return isFloat32() ? rowFloat32(i)[j] : row(i)[j];
+    }
+
+    /// @brief Copies row i into a double vector
+    std::vector<double> readRow(int64_t i) const {
+        std::vector<double> result(static_cast<size_t>(N()));
+        for (int64_t j = 0; j < N(); j++) {
+            result[j] = value(i, j);
+        }
+        return result;
+    }
+
+private:
+    bool validate() const {
+        if (length < sizeof(ResultHeader)) return false;
+        const ResultHeader& h = info();
+        if (std::memcmp(h.magic, RESULT_MAGIC, sizeof(RESULT_MAGIC)) != 0) return false;
+        if (h.version != 1 || (h.value_size != 4 && h.value_size != 8)) return false;
+        if (h.N < 0 || h.rows < 0) return false;
+        size_t dataEnd = static_cast<size_t>(h.data_offset + h.rows * h.N * h.value_size);
+        return h.table_offset == static_cast<int64_t>(dataEnd) && dataEnd + h.rows * 16 <= length;
+    }
+
+    MappedFile file;
+    const char* base = nullptr;
+    size_t length = 0;
+};
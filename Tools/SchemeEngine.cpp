@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Schemes.cpp"
+#include "Output.cpp"
+#include "TemporalBlocking.cpp"
+#include "Profiler.cpp"
+
+// Compile-time specialised scheme engine: the stencil, the boundary treatment and
+// the initial condition are policy types, so with -O3 the update loops inline
+// completely and auto-vectorise (the two-buffer stencils use __restrict rows).
+
+/// @struct Set1Initial
+/// @brief Step initial condition 0.5 * (sign(x) + 1)
+struct Set1Initial {
+    inline double operator()(double x) const {
+        double sign = (x > 0) ? 1 : (x < 0) ? -1 : 0;
+        return 0.5 * (sign + 1);
+    }
+};
+
+/// @struct Set2Initial
+/// @brief Gaussian initial condition 0.5 * exp(-x^2)
+struct Set2Initial {
+    inline double operator()(double x) const {
+        return 0.5 * (exp(-x * x));
+    }
+};
+
+/// @struct FunctionInitial
+/// @brief Initial condition from a callable (function pointer or lambda)
+template <class F>
+struct FunctionInitial {
+    F f;
+    inline double operator()(double x) const { return f(x); }
+};
+
+/// @struct HoldInitial
+/// @brief Boundary treatment of the solver: points outside the update range keep their initial value
+struct HoldInitial {
+    inline void apply(double* row, int N, int begin, int end, double left, double right) const {}
+};
+
+/// @struct Dirichlet
+/// @brief Boundary treatment pinning the points left of the update range to `left`
+///        and right of it to `right` (the Bondary values)
+struct Dirichlet {
+    inline void apply(double* row, int N, int begin, int end, double left, double right) const {
+        for (int i = 0; i < begin; i++) row[i] = left;
+        for (int i = end; i < N; i++) row[i] = right;
+    }
+};
+
+/// @struct FTBSStencil
+/// @brief Explicit FTBS: two rows, reach one point to the left
+struct FTBSStencil {
+    static const bool blockable = true;
+    static const int left = 1;
+    static const int right = 0;
+
+    static void range(int N, int& begin, int& end) { begin = 1; end = N; }
+
+    static void row(const SchemeCoefficients& k, const double* __restrict prev, double* __restrict next, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            next[i] = Row_Schemes::FTBS_point(k, prev, i);
+        }
+    }
+
+    static inline void step(const SchemeCoefficients& k, double*& current, double*& spare, double* half, int begin, int end) {
+        row(k, current, spare, begin, end);
+        std::swap(current, spare);
+    }
+};
+
+/// @struct LaxWendroffStencil
+/// @brief Lax-Wendroff: two rows, reach one point on each side
+struct LaxWendroffStencil {
+    static const bool blockable = true;
+    static const int left = 1;
+    static const int right = 1;
+
+    static void range(int N, int& begin, int& end) { begin = 2; end = N - 2; }
+
+    static void row(const SchemeCoefficients& k, const double* __restrict prev, double* __restrict next, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            next[i] = Row_Schemes::Lax_Wendroff_point(k, prev, i);
+        }
+    }
+
+    static inline void step(const SchemeCoefficients& k, double*& current, double*& spare, double* half, int begin, int end) {
+        row(k, current, spare, begin, end);
+        std::swap(current, spare);
+    }
+};
+
+/// @struct ImplicitFTBSStencil
+/// @brief Implicit FTBS: right-to-left sweep in place
+struct ImplicitFTBSStencil {
+    static const bool blockable = false;
+    static const int left = 1;
+    static const int right = 0;
+
+    static void range(int N, int& begin, int& end) { begin = 2; end = N - 1; }
+
+    static inline void step(const SchemeCoefficients& k, double*& current, double*& spare, double* half, int begin, int end) {
+        Row_Schemes::I_FTBS(k, current, current, begin, end);
+    }
+};
+
+/// @struct RichtmyerStencil
+/// @brief Richtmyer two-step: prediction into the half row, correction in place
+struct RichtmyerStencil {
+    static const bool blockable = false;
+    static const int left = 1;
+    static const int right = 1;
+
+    static void range(int N, int& begin, int& end) { begin = 1; end = N - 2; }
+
+    /// @brief Prediction into the half row (the two rows never alias here)
+    static void predict(const SchemeCoefficients& k, const double* __restrict prev, double* __restrict half, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            half[i] = Row_Schemes::Richtmyer_prediction_point(k, prev, i);
+        }
+    }
+
+    static inline void step(const SchemeCoefficients& k, double*& current, double*& spare, double* half, int begin, int end) {
+        predict(k, current, half, begin, end);
+        for (int i = begin; i < end; i++) {
+            current[i] = Row_Schemes::Richtmyer_correction_point(k, current, half, i);
+        }
+    }
+};
+
+/// @struct EngineRun
+/// @brief Runtime parameters of an engine run
+struct EngineRun {
+    int N;                        ///< Number of points
+    double x_min;                 ///< x of the first point
+    double dx;                    ///< Spatial step size
+    double dt;                    ///< Time step size
+    int steps;                    ///< Number of steps after the initial level
+    SchemeCoefficients k;         ///< Precomputed coefficients
+    const RecordSchedule* schedule; ///< Recorded levels
+    double left;                  ///< Left boundary value (Dirichlet)
+    double right;                 ///< Right boundary value (Dirichlet)
+    double (*t0_function)(double); ///< Initial condition for FunctionInitial runs
+    int blockLevels;              ///< Temporal blocking depth (1: none)
+    int blockTile;                ///< Temporal blocking tile width
+    int first = 0;                ///< Level the run starts from (0: the initial condition)
+    const double* start = nullptr; ///< Row of level `first` when resuming (nullptr: the initial condition)
+};
+
+/// @class SchemeEngine
+/// @brief Streaming stepping loop specialised for a stencil, an initial condition and a boundary treatment
+template <class Stencil, class Initial, class Boundary = HoldInitial>
+class SchemeEngine {
+public:
+    /// @brief Evaluates the initial condition (or copies run.start), steps and streams the recorded levels
+    /// @param run Runtime parameters
+    /// @param initial The initial condition
+    /// @param sink Receives the recorded levels (begin/end are the caller's job)
+    static void run(const EngineRun& run, Initial initial, RowSink& sink) {
+        const int N = run.N;
+        const Boundary boundary;
+        int begin, end;
+        Stencil::range(N, begin, end);
+        end = std::max(begin, end);
+
+        std::vector<double> a(N);
+        if (run.start) {
+            std::copy(run.start, run.start + N, a.begin());
+        } else {
+            PROFILE_SCOPE("initial_condition");
+            for (int i = 0; i < N; i++) {
+                double x = run.x_min + i * run.dx;
+                a[i] = initial(x);
+            }
+        }
+        boundary.apply(a.data(), N, begin, end, run.left, run.right);
+        std::vector<double> b = a;
+        std::vector<double> half = a;
+
+        double* current = a.data();
+        double* spare = b.data();
+        TemporalBlocker blocker(run.blockTile);
+        const bool blocking = Stencil::blockable && run.blockLevels > 1;
+        for (int level = run.first; level <= run.steps; level++) {
+            // Blocked stencils jump straight to the next recorded level, at most blockLevels ahead
+            int jump = (blocking && level > run.first) ? std::min(run.blockLevels, run.schedule->next(level - 1) - (level - 1)) : 1;
+            if (jump > 1) {
+                if constexpr (Stencil::blockable) {
+                    blocker.advance(Stencil::row, Stencil::left, Stencil::right, run.k, current, spare, N, begin, end, jump);
+                    std::swap(current, spare);
+                }
+                level += jump - 1;
+            } else if (level > run.first) {
+                Stencil::step(run.k, current, spare, half.data(), begin, end);
+            }
+            if (run.schedule->at(level)) {
+                sink.write(level, level * run.dt, current, N);
+            }
+        }
+    }
+
+    /// @brief Entry point with the initial condition built from the run
+    static void runDefault(const EngineRun& run, RowSink& sink) {
+        SchemeEngine::run(run, makeInitial(run, static_cast<Initial*>(nullptr)), sink);
+    }
+
+private:
+    template <class T>
+    static T makeInitial(const EngineRun& run, T*) { return T(); }
+
+    static FunctionInitial<double (*)(double)> makeInitial(const EngineRun& run, FunctionInitial<double (*)(double)>*) {
+        return FunctionInitial<double (*)(double)>{run.t0_function};
+    }
+};
+
+/// @brief Signature of a registered engine instantiation
+typedef void (*EngineRunner)(const EngineRun& run, RowSink& sink);
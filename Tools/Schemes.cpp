@@ -1,35 +1,193 @@
+#pragma once
+
 #include <iostream>
 #include <fstream>
 #include <vector>
 
 using namespace std;
 
+/// @struct SchemeCoefficients
+/// @brief CFL-derived coefficients of every scheme, computed once per (dx, dt, u)
+/// @note Each coefficient is evaluated with the same operation order as the per-point
+///       formulas so the row kernels reproduce them bit for bit
+struct SchemeCoefficients {
+    double dx;          ///< Spatial step size
+    double dt;          ///< Time step size
+    double u;           ///< Advection velocity
+    double c;           ///< Courant number u * dt / dx
+    double lw_advect;   ///< Lax-Wendroff first order term u * dt / (2 * dx)
+    double lw_diffuse;  ///< Lax-Wendroff second order term (u^2 * dt^2 / dx^2) * 0.5
+    double i_udt;       ///< Implicit FTBS numerator weight u * dt
+    double i_denom;     ///< Implicit FTBS denominator u * dt + dx
+    double r_predict;   ///< Richtmyer prediction weight (u * dt / dx) * 0.25
+    double r_correct;   ///< Richtmyer correction weight (u * dt / dx) * 0.5
+    double bt_implicit; ///< BTCS off-diagonal weight (u * dt / dx) * 0.5
+    double cn_implicit; ///< Crank-Nicolson off-diagonal and explicit weight (u * dt / dx) * 0.25
+
+    /// @brief Precomputes the coefficients for a given discretisation
+    /// @param dx The spatial step size
+    /// @param dt The time step size
+    /// @param u Advection velocity
+    /// @return The coefficient set
+    static SchemeCoefficients make(double dx, double dt, double u) {
+        SchemeCoefficients k;
+        k.dx = dx;
+        k.dt = dt;
+        k.u = u;
+        k.c = u * dt / dx;
+        k.lw_advect = u * dt / (2 * dx);
+        k.lw_diffuse = (u * u * dt * dt / (dx * dx)) * 0.5;
+        k.i_udt = u * dt;
+        k.i_denom = u * dt + dx;
+        k.r_predict = (u * dt / dx) * 0.25;
+        k.r_correct = (u * dt / dx) * 0.5;
+        k.bt_implicit = (u * dt / dx) * 0.5;
+        k.cn_implicit = (u * dt / dx) * 0.25;
+        return k;
+    }
+};
+
+/// @class Row_Schemes
+/// @brief Row-level kernels advancing a whole time level over [begin, end) in one call
+/// @note `prev` and `next` are contiguous rows of the same length; only indices in
+///       [begin, end) of the output are written. The `*_point` helpers are the single
+///       point updates shared by the row loops and the legacy per-point functions.
+class Row_Schemes {
+public:
+    /// @brief Explicit FTBS update of point i
+    static inline double FTBS_point(const SchemeCoefficients& k, const double* prev, int i) {
+        return prev[i] - k.c * (prev[i] - prev[i - 1]);
+    }
+
+    /// @brief Lax-Wendroff update of point i
+    static inline double Lax_Wendroff_point(const SchemeCoefficients& k, const double* prev, int i) {
+        return prev[i] - k.lw_advect * (prev[i + 1] - prev[i - 1]) +
+               k.lw_diffuse * (prev[i + 1] - 2 * prev[i] + prev[i - 1]);
+    }
+
+    /// @brief Implicit FTBS update of point i given the value at the previous point
+    static inline double I_FTBS_point(const SchemeCoefficients& k, double lastPoint, const double* prev, int i) {
+        return (k.i_udt * lastPoint + k.dx * prev[i]) / k.i_denom;
+    }
+
+    /// @brief Richtmyer prediction of point i
+    static inline double Richtmyer_prediction_point(const SchemeCoefficients& k, const double* prev, int i) {
+        return 0.5 * (prev[i + 1] + prev[i - 1]) - k.r_predict * (prev[i + 1] - prev[i - 1]);
+    }
+
+    /// @brief Richtmyer correction of point i
+    static inline double Richtmyer_correction_point(const SchemeCoefficients& k, const double* prev, const double* half, int i) {
+        return prev[i] - k.r_correct * (half[i + 1] - half[i - 1]);
+    }
+
+    /// @brief Explicit half of the Crank-Nicolson update of point i (its right-hand side)
+    static inline double Crank_Nicolson_rhs_point(const SchemeCoefficients& k, const double* prev, int i) {
+        return prev[i] - k.cn_implicit * (prev[i + 1] - prev[i - 1]);
+    }
+
+    /// @brief Explicit FTBS over a range of points
+    /// @param k Precomputed coefficients
+    /// @param prev The previous time level
+    /// @param next The time level being computed (must not alias prev)
+    /// @param begin First index to update (>= 1)
+    /// @param end One past the last index to update
+    static void FTBS(const SchemeCoefficients& k, const double* prev, double* next, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            next[i] = FTBS_point(k, prev, i);
+        }
+    }
+
+    /// @brief Lax-Wendroff over a range of points
+    /// @param k Precomputed coefficients
+    /// @param prev The previous time level
+    /// @param next The time level being computed (must not alias prev)
+    /// @param begin First index to update (>= 1)
+    /// @param end One past the last index to update (<= size - 1)
+    static void Lax_Wendroff(const SchemeCoefficients& k, const double* prev, double* next, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            next[i] = Lax_Wendroff_point(k, prev, i);
+        }
+    }
+
+    /// @brief Implicit FTBS sweep from right to left over a range of points
+    /// @param k Precomputed coefficients
+    /// @param prev The previous time level (may alias row)
+    /// @param row The time level being computed; row[i - 1] is read as the last point
+    /// @param begin First index to update (>= 1)
+    /// @param end One past the last index to update
+    static void I_FTBS(const SchemeCoefficients& k, const double* prev, double* row, int begin, int end) {
+        for (int i = end - 1; i >= begin; i--) {
+            row[i] = I_FTBS_point(k, row[i - 1], prev, i);
+        }
+    }
+
+    /// @brief Richtmyer prediction step over a range of points
+    /// @param k Precomputed coefficients
+    /// @param prev The previous time level
+    /// @param half The predicted values (must not alias prev)
+    /// @param begin First index to update (>= 1)
+    /// @param end One past the last index to update (<= size - 1)
+    static void Richtmyer_prediction(const SchemeCoefficients& k, const double* prev, double* half, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            half[i] = Richtmyer_prediction_point(k, prev, i);
+        }
+    }
+
+    /// @brief Richtmyer correction step over a range of points
+    /// @param k Precomputed coefficients
+    /// @param prev The previous time level (may alias next)
+    /// @param half The predicted values
+    /// @param next The time level being computed
+    /// @param begin First index to update (>= 1)
+    /// @param end One past the last index to update (<= size - 1)
+    static void Richtmyer_correction(const SchemeCoefficients& k, const double* prev, const double* half, double* next, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            next[i] = Richtmyer_correction_point(k, prev, half, i);
+        }
+    }
+
+    /// @brief Crank-Nicolson right-hand side over a range of points
+    /// @param k Precomputed coefficients
+    /// @param prev The previous time level
+    /// @param rhs Receives the explicit half of the update (must not alias prev)
+    /// @param begin First index to update (>= 1)
+    /// @param end One past the last index to update (<= size - 1)
+    static void Crank_Nicolson_rhs(const SchemeCoefficients& k, const double* prev, double* rhs, int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            rhs[i] = Crank_Nicolson_rhs_point(k, prev, i);
+        }
+    }
+};
+
 class Explicit_Schemes {
 public:
     /// @brief Computes the forward finite difference of a function
     /// @param x The point at which the derivative is calculated
     /// @param dx The step size
-    /// @param f The function whose derivative is being computed
+    /// @param f The function whose derivative is being computed (function pointer or lambda, inlined)
     /// @return Approximate derivative using forward difference
-    static double forward_diff(double x, double dx, double (*f)(double)) {
+    template <class F>
+    static double forward_diff(double x, double dx, F f) {
         return (f(x + dx) - f(x)) / dx;
     }
 
     /// @brief Computes the backward finite difference of a function
     /// @param x The point at which the derivative is calculated
     /// @param dx The step size
-    /// @param f The function whose derivative is being computed
+    /// @param f The function whose derivative is being computed (function pointer or lambda, inlined)
     /// @return Approximate derivative using backward difference
-    static double backward_diff(double x, double dx, double (*f)(double)) {
+    template <class F>
+    static double backward_diff(double x, double dx, F f) {
         return (f(x) - f(x - dx)) / dx;
     }
 
     /// @brief Computes the central finite difference of a function
     /// @param x The point at which the derivative is calculated
     /// @param dx The step size
-    /// @param f The function whose derivative is being computed
+    /// @param f The function whose derivative is being computed (function pointer or lambda, inlined)
     /// @return Approximate derivative using central difference
-    static double central_diff(double x, double dx, double (*f)(double)) {
+    template <class F>
+    static double central_diff(double x, double dx, F f) {
         return (f(x + dx) - f(x - dx)) / (2 * dx);
     }
 
@@ -38,9 +196,10 @@ public:
     /// @param dx The spatial step size
     /// @param dt The time step size
     /// @param u Advection velocity
-    /// @param f The function representing the previous time step
+    /// @param f The function representing the previous time step (function pointer or lambda, inlined)
     /// @return Approximation using FTBS
-    static double FTBS(double x, double dx, double dt, double u, double (*f)(double)) {
+    template <class F>
+    static double FTBS(double x, double dx, double dt, double u, F f) {
         return f(x) - (u * dt / dx) * (f(x) - f(x - dx));
     }
 
@@ -52,8 +211,8 @@ public:
     /// @param precedentArray The array holding previous time step values
     /// @param i The index of the current point in the array
     /// @return Approximation using FTBS with precedent array
-    static double FTBS_alternative(double x, double dx, double dt, double u, vector<double> precedentArray, int i) {
-        return precedentArray[i] - (u * dt / dx) * (precedentArray[i] - precedentArray[i - 1]);
+    static double FTBS_alternative(double x, double dx, double dt, double u, const vector<double>& precedentArray, int i) {
+        return Row_Schemes::FTBS_point(SchemeCoefficients::make(dx, dt, u), precedentArray.data(), i);
     }
 
     /// @brief Computes the Lax-Wendroff scheme for higher accuracy
@@ -64,9 +223,8 @@ public:
     /// @param precedentArray The array holding previous time step values
     /// @param i The index of the current point in the array
     /// @return Approximation using the Lax-Wendroff scheme
-    static double Lax_Wendroff(double x, double dx, double dt, double u, vector<double> precedentArray, int i) {
-        return precedentArray[i] - (u * dt / (2 * dx)) * (precedentArray[i + 1] - precedentArray[i - 1]) +
-               (u * u * dt * dt / (dx * dx)) * 0.5 * (precedentArray[i + 1] - 2 * precedentArray[i] + precedentArray[i - 1]);
+    static double Lax_Wendroff(double x, double dx, double dt, double u, const vector<double>& precedentArray, int i) {
+        return Row_Schemes::Lax_Wendroff_point(SchemeCoefficients::make(dx, dt, u), precedentArray.data(), i);
     }
 };
 
@@ -77,9 +235,10 @@ public:
     /// @param dx The spatial step size
     /// @param dt The time step size
     /// @param u Advection velocity
-    /// @param f The function representing the previous time step
+    /// @param f The function representing the previous time step (function pointer or lambda, inlined)
     /// @return Approximation using implicit FTBS
-    static double FTBS(double x, double dx, double dt, double u, double (*f)(double)) {
+    template <class F>
+    static double FTBS(double x, double dx, double dt, double u, F f) {
         return 1 / (1 + u * dt / dx) * (f(x) + u * dt / dx * f(x - dx));  // CFL condition applied
     }
 
@@ -88,9 +247,10 @@ public:
     /// @param dx The spatial step size
     /// @param dt The time step size
     /// @param u Advection velocity
-    /// @param f The function representing the previous time step
+    /// @param f The function representing the previous time step (function pointer or lambda, inlined)
     /// @return Approximation using implicit FTBS
-    static double I_FTBS(double x, double dx, double dt, double u, double (*f)(double)) {
+    template <class F>
+    static double I_FTBS(double x, double dx, double dt, double u, F f) {
         return (u * dt * f(x - dx) + dx * f(x)) / (u * dt + dx);
     }
 
@@ -103,8 +263,8 @@ public:
     /// @param precedentArray The array holding values from the previous time step
     /// @param i The index of the current point in the array
     /// @return Approximation using implicit FTBS with an alternative method
-    static double I_FTBS_alternative(double x, double dx, double dt, double u, double lastPoint, vector<double> precedentArray, int i) {
-        return (u * dt * lastPoint + dx * precedentArray[i]) / (u * dt + dx);
+    static double I_FTBS_alternative(double x, double dx, double dt, double u, double lastPoint, const vector<double>& precedentArray, int i) {
+        return Row_Schemes::I_FTBS_point(SchemeCoefficients::make(dx, dt, u), lastPoint, precedentArray.data(), i);
     }
 };
 
@@ -118,9 +278,8 @@ public:
     /// @param precedentArray The array holding previous time step values
     /// @param i The index of the current point in the array
     /// @return Predicted value at the midpoint using Richtmyer method
-    static double Ritchmyer_method_prediction(double x, double dx, double dt, double u, vector<double> precedentArray, int i) {
-        return 0.5 * (precedentArray[i + 1] + precedentArray[i - 1]) -
-               (u * dt / dx) * 0.25 * (precedentArray[i + 1] - precedentArray[i - 1]);
+    static double Ritchmyer_method_prediction(double x, double dx, double dt, double u, const vector<double>& precedentArray, int i) {
+        return Row_Schemes::Richtmyer_prediction_point(SchemeCoefficients::make(dx, dt, u), precedentArray.data(), i);
     }
 
     /// @brief Computes the correction step of the Richtmyer method
@@ -132,7 +291,7 @@ public:
     /// @param stepArray The array holding predicted values
     /// @param i The index of the current point in the array
     /// @return Corrected value at the midpoint using Richtmyer method
-    static double Ritchmyer_method_correction(double x, double dx, double dt, double u, vector<double> precedentArray, vector<double> stepArray, int i) {
-        return precedentArray[i] - (u * dt / dx) * 0.5 * (stepArray[i + 1] - stepArray[i - 1]);
+    static double Ritchmyer_method_correction(double x, double dx, double dt, double u, const vector<double>& precedentArray, const vector<double>& stepArray, int i) {
+        return Row_Schemes::Richtmyer_correction_point(SchemeCoefficients::make(dx, dt, u), precedentArray.data(), stepArray.data(), i);
     }
 };
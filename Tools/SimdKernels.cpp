@@ -0,0 +1,356 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "Schemes.cpp"
+#include "Output.cpp"
+#include "SchemeEngine.cpp"
+
+// Hand-vectorised row kernels with runtime dispatch. The per-ISA bodies live in
+// SimdRowKernels.cpp, compiled once per instruction set with `#pragma GCC target`
+// so a baseline build still carries the AVX2 and AVX-512 versions.
+//
+// Accuracy: in double precision every lane evaluates the Row_Schemes expression in
+// the same order, and floating-point contraction is disabled in the vector regions,
+// so the kernels agree with the scalar path to 0 ULP. If the scalar path itself is
+// built with FMA contraction (-march=native -ffp-contract=fast), expect up to
+// SIMD_ULP_TOLERANCE ULP per step against it. Float32 runs are checked against a
+// float scalar reference with the same tolerance.
+
+/// @brief Documented agreement bound, in ULP, between a SIMD kernel and the scalar path
+static const int SIMD_ULP_TOLERANCE = 4;
+
+/// @enum SimdISA
+/// @brief Instruction sets with a compiled kernel set
+enum class SimdISA { Scalar, SSE2, AVX2, AVX512 };
+
+/// @enum SimdStencil
+/// @brief Schemes with a vector kernel
+enum class SimdStencil { FTBS, Implicit_FTBS, Lax_Wendroff, Richtmyer };
+
+/// @struct SimdCoefficients
+/// @brief SchemeCoefficients converted to the working precision
+template <class T>
+struct SimdCoefficients {
+    T dx;
+    T c;
+    T lw_advect;
+    T lw_diffuse;
+    T i_udt;
+    T i_denom;
+    T r_predict;
+    T r_correct;
+
+    static SimdCoefficients make(const SchemeCoefficients& k) {
+        SimdCoefficients s;
+        s.dx = static_cast<T>(k.dx);
+        s.c = static_cast<T>(k.c);
+        s.lw_advect = static_cast<T>(k.lw_advect);
+        s.lw_diffuse = static_cast<T>(k.lw_diffuse);
+        s.i_udt = static_cast<T>(k.i_udt);
+        s.i_denom = static_cast<T>(k.i_denom);
+        s.r_predict = static_cast<T>(k.r_predict);
+        s.r_correct = static_cast<T>(k.r_correct);
+        return s;
+    }
+};
+
+/// @brief Scalar kernels, also the float32 reference of the vector kernels
+namespace simd_scalar {
+template <class T>
+void FTBS(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        next[i] = prev[i] - k.c * (prev[i] - prev[i - 1]);
+    }
+}
+
+template <class T>
+void Implicit_FTBS(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        next[i] = (k.i_udt * prev[i - 1] + k.dx * prev[i]) / k.i_denom;
+    }
+}
+
+template <class T>
+void Lax_Wendroff(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        next[i] = prev[i] - k.lw_advect * (prev[i + 1] - prev[i - 1]) +
+                  k.lw_diffuse * (prev[i + 1] - 2 * prev[i] + prev[i - 1]);
+    }
+}
+
+template <class T>
+void Richtmyer_prediction(const SimdCoefficients<T>& k, const T* prev, T* half, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        half[i] = T(0.5) * (prev[i + 1] + prev[i - 1]) - k.r_predict * (prev[i + 1] - prev[i - 1]);
+    }
+}
+
+template <class T>
+void Richtmyer_correction(const SimdCoefficients<T>& k, const T* prev, const T* half, T* next, int i0, int i1) {
+    for (int i = i0; i < i1; i++) {
+        next[i] = prev[i] - k.r_correct * (half[i + 1] - half[i - 1]);
+    }
+}
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_KERNELS_X86 1
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("sse2")
+namespace simd_sse2 {
+#define SIMD_BYTES 16
+#include "SimdRowKernels.cpp"
+#undef SIMD_BYTES
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("avx2")
+namespace simd_avx2 {
+#define SIMD_BYTES 32
+#include "SimdRowKernels.cpp"
+#undef SIMD_BYTES
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC target("avx512f")
+namespace simd_avx512 {
+#define SIMD_BYTES 64
+#include "SimdRowKernels.cpp"
+#undef SIMD_BYTES
+}
+#pragma GCC pop_options
+#endif
+
+/// @brief Name of an instruction set
+inline const char* simdName(SimdISA isa) {
+    switch (isa) {
+    case SimdISA::SSE2: return "SSE2";
+    case SimdISA::AVX2: return "AVX2";
+    case SimdISA::AVX512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+/// @brief Whether this build and this CPU can run an instruction set
+inline bool simdSupported(SimdISA isa) {
+#ifdef SIMD_KERNELS_X86
+    __builtin_cpu_init();
+    switch (isa) {
+    case SimdISA::SSE2: return __builtin_cpu_supports("sse2");
+    case SimdISA::AVX2: return __builtin_cpu_supports("avx2");
+    case SimdISA::AVX512: return __builtin_cpu_supports("avx512f");
+    default: return true;
+    }
+#else
+    return isa == SimdISA::Scalar;
+#endif
+}
+
+/// @brief Widest instruction set supported at runtime
+inline SimdISA simdBest() {
+    for (SimdISA isa : {SimdISA::AVX512, SimdISA::AVX2, SimdISA::SSE2}) {
+        if (simdSupported(isa)) return isa;
+    }
+    return SimdISA::Scalar;
+}
+
+/// @struct SimdKernelSet
+/// @brief Row kernels of one instruction set and one precision
+template <class T>
+struct SimdKernelSet {
+    typedef void (*Row)(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1);
+    typedef void (*Correction)(const SimdCoefficients<T>& k, const T* prev, const T* half, T* next, int i0, int i1);
+
+    SimdISA isa;
+    int width;      ///< Elements per vector; ranges are processed in whole vectors
+    Row ftbs;
+    Row implicit_ftbs;
+    Row lax_wendroff;
+    Row predict;
+    Correction correct;
+
+    /// @brief Kernel set for an instruction set, falling back to scalar when unsupported
+    static SimdKernelSet select(SimdISA isa) {
+        if (!simdSupported(isa)) isa = SimdISA::Scalar;
+        switch (isa) {
+#ifdef SIMD_KERNELS_X86
+        case SimdISA::SSE2:
+            return make<simd_sse2::Vec<T>::W>(isa, simd_sse2::FTBS<T>, simd_sse2::Implicit_FTBS<T>, simd_sse2::Lax_Wendroff<T>,
+                                              simd_sse2::Richtmyer_prediction<T>, simd_sse2::Richtmyer_correction<T>);
+        case SimdISA::AVX2:
+            return make<simd_avx2::Vec<T>::W>(isa, simd_avx2::FTBS<T>, simd_avx2::Implicit_FTBS<T>, simd_avx2::Lax_Wendroff<T>,
+                                              simd_avx2::Richtmyer_prediction<T>, simd_avx2::Richtmyer_correction<T>);
+        case SimdISA::AVX512:
+            return make<simd_avx512::Vec<T>::W>(isa, simd_avx512::FTBS<T>, simd_avx512::Implicit_FTBS<T>, simd_avx512::Lax_Wendroff<T>,
+                                                simd_avx512::Richtmyer_prediction<T>, simd_avx512::Richtmyer_correction<T>);
+#endif
+        default:
+            return make<1>(SimdISA::Scalar, simd_scalar::FTBS<T>, simd_scalar::Implicit_FTBS<T>, simd_scalar::Lax_Wendroff<T>,
+                           simd_scalar::Richtmyer_prediction<T>, simd_scalar::Richtmyer_correction<T>);
+        }
+    }
+
+private:
+    template <int W>
+    static SimdKernelSet make(SimdISA isa, Row ftbs, Row implicit_ftbs, Row lax_wendroff, Row predict, Correction correct) {
+        SimdKernelSet set;
+        set.isa = isa;
+        set.width = W;
+        set.ftbs = ftbs;
+        set.implicit_ftbs = implicit_ftbs;
+        set.lax_wendroff = lax_wendroff;
+        set.predict = predict;
+        set.correct = correct;
+        return set;
+    }
+};
+
+/// @class SimdRow
+/// @brief Row of N points, 64-byte aligned, with PAD zero points on each side
+/// @note The padding lets the kernels run whole aligned vectors past both ends of
+///       the update range (including the i - 1 and i + 1 neighbours) without any
+///       boundary special case.
+template <class T>
+class SimdRow {
+public:
+    static const int ALIGN = 64;
+    static const int PAD = 2 * ALIGN / static_cast<int>(sizeof(T));
+
+    SimdRow(int n = 0) { resize(n); }
+    SimdRow(const SimdRow&) = delete;
+    SimdRow& operator=(const SimdRow&) = delete;
+
+    void resize(int n) {
+        count = n;
+        storage.assign(n + 2 * PAD + ALIGN / sizeof(T), T(0));
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.data() + PAD);
+        size_t shift = ((ALIGN - address % ALIGN) % ALIGN) / sizeof(T);
+        base = storage.data() + PAD + shift;
+    }
+
+    T* data() { return base; }
+    const T* data() const { return base; }
+    int size() const { return count; }
+    T& operator[](int i) { return base[i]; }
+    const T& operator[](int i) const { return base[i]; }
+
+private:
+    std::vector<T> storage;
+    T* base = nullptr;
+    int count = 0;
+};
+
+/// @class SimdStepper
+/// @brief Advances a padded row one level with a kernel set
+template <class T>
+class SimdStepper {
+public:
+    SimdStepper(const SimdKernelSet<T>& kernels, const SimdCoefficients<T>& k, int begin, int end)
+        : kernels(kernels), k(k), begin(begin), end(end) {
+        const int W = kernels.width;
+        i0 = begin - begin % W;
+        i1 = end + (W - end % W) % W;
+    }
+
+    /// @brief One step of a stencil
+    /// @param current The current level (advanced in place for the Richtmyer correction)
+    /// @param spare The other row of two-row schemes; swapped with current
+    /// @param half The Richtmyer prediction row
+    void step(SimdStencil stencil, T*& current, T*& spare, T* half) {
+        switch (stencil) {
+        case SimdStencil::FTBS: twoRow(kernels.ftbs, current, spare); break;
+        case SimdStencil::Implicit_FTBS: twoRow(kernels.implicit_ftbs, current, spare); break;
+        case SimdStencil::Lax_Wendroff: twoRow(kernels.lax_wendroff, current, spare); break;
+        case SimdStencil::Richtmyer:
+            save(half);
+            kernels.predict(k, current, half, i0, i1);
+            restore(half);
+            save(current);
+            kernels.correct(k, current, half, current, i0, i1);
+            restore(current);
+            break;
+        }
+    }
+
+private:
+    void twoRow(typename SimdKernelSet<T>::Row kernel, T*& current, T*& spare) {
+        save(spare);
+        kernel(k, current, spare, i0, i1);
+        restore(spare);
+        std::swap(current, spare);
+    }
+
+    // The vector blocks overrun [begin, end) by less than a vector on each side;
+    // those points keep their values
+    void save(const T* row) {
+        int n = 0;
+        for (int i = i0; i < begin; i++) saved[n++] = row[i];
+        for (int i = end; i < i1; i++) saved[n++] = row[i];
+    }
+
+    void restore(T* row) const {
+        int n = 0;
+        for (int i = i0; i < begin; i++) row[i] = saved[n++];
+        for (int i = end; i < i1; i++) row[i] = saved[n++];
+    }
+
+    SimdKernelSet<T> kernels;
+    SimdCoefficients<T> k;
+    int begin, end, i0, i1;
+    std::array<T, 2 * SimdRow<T>::PAD> saved;
+};
+
+/// @class SimdEngine
+/// @brief Streaming stepping loop on padded rows with the vector kernels
+template <class T>
+class SimdEngine {
+public:
+    /// @brief Steps from an initial level and streams the recorded levels as double rows
+    /// @param isa Instruction set (falls back to scalar when unsupported)
+    /// @param stencil The scheme
+    /// @param run Runtime parameters (blocking fields are ignored)
+    /// @param initial The level run.first (the initial condition unless resuming)
+    /// @param begin First updated index
+    /// @param end One past the last updated index
+    /// @param sink Receives the recorded levels (begin/end are the caller's job)
+    static void run(SimdISA isa, SimdStencil stencil, const EngineRun& run, const std::vector<double>& initial,
+                    int begin, int end, RowSink& sink) {
+        const int N = run.N;
+        SimdRow<T> a(N), b(N), half(N);
+        for (int i = 0; i < N; i++) {
+            a[i] = b[i] = half[i] = static_cast<T>(initial[i]);
+        }
+        SimdStepper<T> stepper(SimdKernelSet<T>::select(isa), SimdCoefficients<T>::make(run.k), begin, end);
+        std::vector<double> out(std::is_same<T, double>::value ? 0 : N);
+
+        T* current = a.data();
+        T* spare = b.data();
+        for (int level = run.first; level <= run.steps; level++) {
+            if (level > run.first) {
+                stepper.step(stencil, current, spare, half.data());
+            }
+            if (run.schedule->at(level)) {
+                sink.write(level, level * run.dt, widen(current, out, N), N);
+            }
+        }
+    }
+
+private:
+    static const double* widen(const double* row, std::vector<double>& out, int N) { return row; }
+
+    static const double* widen(const float* row, std::vector<double>& out, int N) {
+        for (int i = 0; i < N; i++) out[i] = row[i];
+        return out.data();
+    }
+};
@@ -0,0 +1,89 @@
+// Vector row kernels, included once per instruction set by SimdKernels.cpp inside a
+// namespace and a `#pragma GCC target` region, with SIMD_BYTES set to the vector
+// width. The kernels process whole vectors over [i0, i1), which the caller aligns
+// to the vector width inside a padded SimdRow, so there is no scalar tail.
+// Every lane performs the same operations in the same order as Row_Schemes.
+
+template <class T>
+struct Vec {
+    typedef T type __attribute__((vector_size(SIMD_BYTES)));
+    static const int W = SIMD_BYTES / sizeof(T);
+
+    static inline type load(const T* p) {
+        type v;
+        __builtin_memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline void store(T* p, type v) {
+        __builtin_memcpy(p, &v, sizeof(v));
+    }
+
+    static inline type splat(T x) {
+        return type{} + x;
+    }
+};
+
+template <class T>
+void FTBS(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1) {
+    typedef Vec<T> V;
+    const typename V::type c = V::splat(k.c);
+    for (int i = i0; i < i1; i += V::W) {
+        typename V::type p = V::load(prev + i);
+        typename V::type l = V::load(prev + i - 1);
+        V::store(next + i, p - c * (p - l));
+    }
+}
+
+// The descending in-place I_FTBS sweep reads row[i - 1] before it is overwritten,
+// so it is the explicit two-row update below
+template <class T>
+void Implicit_FTBS(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1) {
+    typedef Vec<T> V;
+    const typename V::type udt = V::splat(k.i_udt);
+    const typename V::type dx = V::splat(k.dx);
+    const typename V::type denom = V::splat(k.i_denom);
+    for (int i = i0; i < i1; i += V::W) {
+        typename V::type p = V::load(prev + i);
+        typename V::type l = V::load(prev + i - 1);
+        V::store(next + i, (udt * l + dx * p) / denom);
+    }
+}
+
+template <class T>
+void Lax_Wendroff(const SimdCoefficients<T>& k, const T* prev, T* next, int i0, int i1) {
+    typedef Vec<T> V;
+    const typename V::type a = V::splat(k.lw_advect);
+    const typename V::type b = V::splat(k.lw_diffuse);
+    const typename V::type two = V::splat(2);
+    for (int i = i0; i < i1; i += V::W) {
+        typename V::type p = V::load(prev + i);
+        typename V::type l = V::load(prev + i - 1);
+        typename V::type r = V::load(prev + i + 1);
+        V::store(next + i, p - a * (r - l) + b * (r - two * p + l));
+    }
+}
+
+template <class T>
+void Richtmyer_prediction(const SimdCoefficients<T>& k, const T* prev, T* half, int i0, int i1) {
+    typedef Vec<T> V;
+    const typename V::type r = V::splat(k.r_predict);
+    const typename V::type h = V::splat(0.5);
+    for (int i = i0; i < i1; i += V::W) {
+        typename V::type left = V::load(prev + i - 1);
+        typename V::type right = V::load(prev + i + 1);
+        V::store(half + i, h * (right + left) - r * (right - left));
+    }
+}
+
+template <class T>
+void Richtmyer_correction(const SimdCoefficients<T>& k, const T* prev, const T* half, T* next, int i0, int i1) {
+    typedef Vec<T> V;
+    const typename V::type r = V::splat(k.r_correct);
+    for (int i = i0; i < i1; i += V::W) {
+        typename V::type p = V::load(prev + i);
+        typename V::type left = V::load(half + i - 1);
+        typename V::type right = V::load(half + i + 1);
+        V::store(next + i, p - r * (right - left));
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+
+#include "WaveEquationSolver.cpp"
+#include "ThreadPool.cpp"
+
+/// @struct SweepJob
+/// @brief One solve of a parameter sweep
+struct SweepJob {
+    int index;                        ///< Position in the job list (defines the output order)
+    Input input;                      ///< Parameters of the solve
+    WaveEquationSolver::Scheme scheme; ///< Scheme to run
+    std::string name;                 ///< File stem: [Scheme]_[SET]_[N]_[Tmax][_u.._CFL..]
+    double seconds = 0;               ///< Wall time of the job once it has run
+};
+
+/// @struct SweepSpace
+/// @brief Cartesian product of sweep parameters
+struct SweepSpace {
+    double L = 100.0;                 ///< Domain length, centred on 0
+    std::vector<int> N;               ///< Numbers of spatial points
+    std::vector<Bondary> bondaries;   ///< Boundary sets
+    std::vector<double> u;            ///< Advection velocities
+    std::vector<double> CFL;          ///< CFL numbers
+    std::vector<int> t_max;           ///< Simulation times
+    std::vector<WaveEquationSolver::Scheme> schemes; ///< Schemes
+
+    /// @brief Expands the product into a job list
+    /// @return Jobs ordered by N, boundary set, u, CFL, t_max, then scheme
+    /// @note u and CFL are appended to the file names only when they vary
+    std::vector<SweepJob> jobs() const {
+        std::vector<SweepJob> result;
+        for (int n : N) {
+            for (const Bondary& bondary : bondaries) {
+                for (double velocity : u) {
+                    for (double cfl : CFL) {
+                        for (int t : t_max) {
+                            for (WaveEquationSolver::Scheme scheme : schemes) {
+                                SweepJob job;
+                                job.index = static_cast<int>(result.size());
+                                job.input = {velocity, L, -L / 2, L / 2, t, n, cfl, bondary};
+                                job.scheme = scheme;
+                                job.name = WaveEquationSolver::schemeName(scheme) + "_" + bondaryName(bondary) + "_" +
+                                           std::to_string(n) + "_" + std::to_string(t);
+                                if (u.size() > 1) job.name += "_u" + shortNumber(velocity);
+                                if (CFL.size() > 1) job.name += "_CFL" + shortNumber(cfl);
+                                result.push_back(job);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+private:
+    static std::string shortNumber(double value) {
+        std::ostringstream out;
+        out << value;
+        return out.str();
+    }
+};
+
+/// @class SweepRunner
+/// @brief Runs independent sweep jobs concurrently on a work-stealing thread pool
+/// @note Each job owns its solver. Jobs are started largest first (N x steps) so
+///       big solves do not straggle at the end; whatever the schedule, the outputs
+///       only depend on the job and the summary is printed in job order.
+class SweepRunner {
+public:
+    typedef std::function<void(WaveEquationSolver& solver, SweepJob& job)> Body;
+
+    /// @brief Constructor
+    /// @param threads Number of worker threads (0: one per hardware thread)
+    /// @param verbose Print progress and the per-job timing summary
+    SweepRunner(unsigned threads = 0, bool verbose = true) : threads(threads), verbose(verbose) {}
+
+    /// @brief Runs every job
+    /// @param jobs The jobs; their `seconds` field is filled in
+    /// @param body Called with a fresh solver for each job
+    void run(std::vector<SweepJob>& jobs, const Body& body) {
+        std::vector<size_t> order(jobs.size());
+        std::vector<double> cost(jobs.size());
+        for (size_t i = 0; i < jobs.size(); i++) {
+            order[i] = i;
+            WaveEquationSolver probe(jobs[i].input);
+            cost[i] = static_cast<double>(jobs[i].input.N) * jobs[i].input.t_max / probe.dt;
+        }
+        std::stable_sort(order.begin(), order.end(), [&cost](size_t a, size_t b) { return cost[a] > cost[b]; });
+
+        auto start = std::chrono::steady_clock::now();
+        size_t finished = 0;
+        std::mutex progress;
+        {
+            ThreadPool pool(threads);
+            if (verbose) {
+                std::cout << "Sweep: " << jobs.size() << " jobs on " << pool.size() << " threads" << std::endl;
+            }
+            for (size_t i : order) {
+                SweepJob* job = &jobs[i];
+                pool.submit([&, job]() {
+                    auto jobStart = std::chrono::steady_clock::now();
+                    WaveEquationSolver solver(job->input);
+                    body(solver, *job);
+                    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - jobStart;
+                    job->seconds = elapsed.count();
+
+                    std::lock_guard<std::mutex> lock(progress);
+                    finished++;
+                    if (verbose) {
+                        std::printf("[%zu/%zu] %-32s %9.3f s\n", finished, jobs.size(), job->name.c_str(), job->seconds);
+                        std::fflush(stdout);
+                    }
+                });
+            }
+            pool.wait();
+        }
+        std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+
+        if (verbose) {
+            double sum = 0;
+            std::cout << "Per-job wall time:" << std::endl;
+            for (const SweepJob& job : jobs) {
+                std::printf("  %4d %-32s %9.3f s\n", job.index, job.name.c_str(), job.seconds);
+                sum += job.seconds;
+            }
+            std::printf("Sweep done: %.3f s wall, %.3f s summed over jobs\n", total.count(), sum);
+        }
+    }
+
+private:
+    unsigned threads;
+    bool verbose;
+};
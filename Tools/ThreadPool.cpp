@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+/// @class ThreadPool
+/// @brief Fixed-size pool of worker threads with per-worker queues and work stealing
+/// @note Tasks are dealt round-robin to the worker queues. A worker pops its own
+///       queue first and steals from the others once it runs dry, so one worker
+///       stuck on a long task does not hold back the tasks queued behind it.
+///       Queues are FIFO: submitting the most expensive tasks first keeps them first.
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    /// @brief Constructor
+    /// @param threads Number of workers (0: one per hardware thread)
+    ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; i++) {
+            queues.emplace_back(new Queue());
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            workers.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Waits for the queued tasks and stops the workers
+    ~ThreadPool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    /// @brief Number of worker threads
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    /// @brief Queues a task
+    /// @param task The task; it must not throw
+    void submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending++;
+            queued++;
+        }
+        Queue& queue = *queues[next++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    /// @brief Blocks until every submitted task has finished
+    /// @note Must not be called from inside a task
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    /// @brief Runs body(i) for i in [0, count) on the pool and waits for completion
+    /// @param count Number of iterations
+    /// @param body The loop body
+    /// @note Must not be called from inside a task
+    void parallelFor(size_t count, const std::function<void(size_t)>& body) {
+        for (size_t i = 0; i < count; i++) {
+            submit([&body, i]() { body(i); });
+        }
+        wait();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(unsigned self, Task& task) {
+        // Own queue first, then steal the oldest task of another worker
+        for (size_t k = 0; k < queues.size(); k++) {
+            Queue& queue = *queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void work(unsigned self) {
+        while (true) {
+            Task task;
+            if (pop(self, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queued--;
+                }
+                task();
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) done.notify_all();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    size_t pending = 0; ///< Submitted tasks not finished yet
+    size_t queued = 0;  ///< Submitted tasks not picked up yet
+    bool stopping = false;
+    std::atomic<size_t> next{0};
+};
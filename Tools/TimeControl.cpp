@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Output.cpp"
+
+/// @struct TimeControl
+/// @brief How a solve chooses its time levels
+/// @note Legacy keeps the historical loops (dt = CFL * dx / u, `t < t_max` step
+///       counts, E_FTBS one step further) and is bit-identical to earlier results.
+///       Exact and Adaptive count integer steps and land exactly on t_max and on
+///       every snapshot time of the RecordPolicy.
+struct TimeControl {
+    /// @enum Mode
+    /// @brief Time-stepping strategy
+    enum Mode {
+        Legacy,   ///< Historical step counts, fixed dt
+        Exact,    ///< Fixed dt per segment between output times, at most the nominal dt
+        Adaptive  ///< dt raised up to the stability limit, optionally error controlled
+    };
+
+    Mode mode = Legacy;
+    double maxCFL = 0;      ///< Adaptive: Courant number ceiling (0: the scheme's stability limit)
+    double safety = 0.9;    ///< Adaptive: fraction of the ceiling and of the error-optimal step used
+    double tolerance = 0;   ///< Adaptive: local error per step, max norm (0: no error control)
+    double growth = 2.0;    ///< Adaptive: largest dt ratio between two accepted steps
+};
+
+/// @class TimeGrid
+/// @brief Integer-step time levels between output stops
+/// @note The stops are the requested output times inside (0, t_max) and t_max
+///       itself. Each segment between two stops gets the smallest whole number of
+///       equal steps not longer than `dt`, and its last level is the stop itself,
+///       so no time drifts and every stop is hit exactly.
+class TimeGrid {
+public:
+    /// @brief Plans the levels of a run
+    /// @param t_max Final time
+    /// @param dt Largest step
+    /// @param times Output times (outside (0, t_max) they add no stop)
+    TimeGrid(double t_max, double dt, const std::vector<double>& times = std::vector<double>()) {
+        stops = TimeGrid::stopsOf(t_max, times);
+        double start = 0;
+        for (double stop : stops) {
+            const double length = stop - start;
+            // Relative slack so a length that is a whole number of dt up to rounding takes that many steps
+            const long long n = std::max(1LL, static_cast<long long>(std::ceil(length / dt * (1 - 1e-12))));
+            segments.push_back(Segment{start, stop, static_cast<int>(n)});
+            start = stop;
+        }
+    }
+
+    /// @brief Sorted unique stops in (0, t_max], t_max last
+    static std::vector<double> stopsOf(double t_max, const std::vector<double>& times) {
+        std::vector<double> result;
+        for (double t : times) {
+            if (t > 0 && t < t_max) result.push_back(t);
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        if (t_max > 0) result.push_back(t_max);
+        return result;
+    }
+
+    /// @brief Total number of steps
+    int steps() const {
+        int total = 0;
+        for (const Segment& segment : segments) total += segment.steps;
+        return total;
+    }
+
+    /// @struct Segment
+    /// @brief `steps` equal steps from `start` to `stop`
+    struct Segment {
+        double start;
+        double stop;
+        int steps;
+
+        double dt() const { return (stop - start) / steps; }
+
+        /// @brief Time of the j-th level of the segment (j = steps gives stop exactly)
+        double time(int j) const { return (j == steps) ? stop : start + j * dt(); }
+    };
+
+    std::vector<Segment> segments;
+    std::vector<double> stops;
+};
+
+/// @class StepController
+/// @brief Chooses the steps of an adaptive run
+/// @note The step is the smallest of the CFL ceiling, the error-controlled step
+///       and the distance to the next stop. When the remaining distance is less
+///       than two steps it is split in two equal steps rather than leaving a
+///       sliver. With a tolerance, the local error of a step is estimated by step
+///       doubling (one step of dt against two of dt / 2, Richardson factor
+///       1 / (2^order - 1)) and the step is rejected when it exceeds the tolerance.
+class StepController {
+public:
+    /// @brief Constructor
+    /// @param control The adaptive parameters
+    /// @param dtLimit Step at the CFL ceiling (may be infinite with error control)
+    /// @param dtStart First step attempted
+    /// @param order Temporal order of the scheme (for the error model)
+    StepController(const TimeControl& control, double dtLimit, double dtStart, int order)
+        : control(control), limit(control.safety * dtLimit), order(order), next(dtStart) {}
+
+    /// @brief Step to attempt from t with the next stop at `stop`
+    /// @param lands Set when the step reaches the stop (the caller then sets t = stop exactly)
+    double propose(double t, double stop, bool& lands) const {
+        double dt = std::min(next, limit);
+        const double remaining = stop - t;
+        lands = (remaining <= dt * (1 + 1e-12));
+        if (lands) return remaining;
+        if (remaining < 2 * dt) return remaining / 2;
+        return dt;
+    }
+
+    /// @brief Whether error control is on
+    bool controlled() const { return control.tolerance > 0; }
+
+    /// @brief Records the step-doubling difference of a step of size dt
+    /// @param dt The attempted step
+    /// @param difference Max-norm difference of the one-step and two-half-step results
+    /// @return Whether the step is accepted; the next proposal is updated either way
+    bool judge(double dt, double difference) {
+        const double error = difference / (std::pow(2.0, order) - 1);
+        const double ratio = (error > 0) ? control.safety * std::pow(control.tolerance / error, 1.0 / (order + 1))
+                                         : control.growth;
+        next = dt * std::min(control.growth, std::max(0.2, ratio));
+        if (error <= control.tolerance) {
+            accepted++;
+            return true;
+        }
+        rejected++;
+        return false;
+    }
+
+    int accepted = 0;  ///< Accepted error-controlled steps
+    int rejected = 0;  ///< Rejected error-controlled steps
+
+private:
+    TimeControl control;
+    double limit;
+    int order;
+    double next;
+};
+
+/// @brief Whether the level reached at time t is recorded in a controlled run
+/// @param policy The record policy (snapshot times are stops, so they are hit exactly)
+/// @param level Index of the level
+/// @param t Time of the level
+/// @param t_max Final time
+inline bool recordedAt(const RecordPolicy& policy, int level, double t, double t_max) {
+    if (policy.every > 0 && level % policy.every == 0) return true;
+    const bool final = (t >= t_max);
+    if (policy.last && final) return true;
+    for (double s : policy.snapshot_times) {
+        if (s == t || (s <= 0 && level == 0) || (s >= t_max && final)) return true;
+    }
+    return false;
+}
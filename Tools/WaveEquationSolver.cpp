@@ -1,3 +1,5 @@
+#pragma once
+
 #include <math.h>
 #include <vector>
 #include <iostream>
@@ -5,6 +7,7 @@
 #include <fstream>
 #include <regex>
 #include <cstdlib>
+#include <memory>
 #ifdef _WIN32
 #include <direct.h> // For _mkdir on Windows
 #else
@@ -12,6 +15,17 @@
 #endif
 
 #include "Schemes.cpp"
+#include "Output.cpp"
+#include "Parallel.cpp"
+#include "TemporalBlocking.cpp"
+#include "SchemeEngine.cpp"
+#include "SimdKernels.cpp"
+#include "NormSink.cpp"
+#include "Banded.cpp"
+#include "TimeControl.cpp"
+#include "Checkpoint.cpp"
+#include "Refinement.cpp"
+#include "Profiler.cpp"
 
 /// @struct Bondary
 /// @brief Represents boundary conditions and initial function for the wave equation
@@ -47,14 +61,23 @@ double sign(double x) {
 /// @param x The input value
 /// @return 0.5 for x >= 0, 0 otherwise
 double SET1_Function(double x) {
-    return 0.5 * (sign(x) + 1);
+    return Set1Initial()(x);
 }
 
 /// @brief Represents a Gaussian-like function
 /// @param x The input value
 /// @return Value of the Gaussian function at x
 double SET2_Function(double x) {
-    return 0.5 * (exp(-x * x));
+    return Set2Initial()(x);
+}
+
+/// @brief Returns the name of a boundary set as used in result file names
+/// @param bondary The boundary set
+/// @return "SET1_sign", "SET2_exp" or "UNKNOWN"
+std::string bondaryName(const Bondary& bondary) {
+    return (bondary.t0_function == SET1_Function) ? "SET1_sign" :
+           (bondary.t0_function == SET2_Function) ? "SET2_exp" :
+           "UNKNOWN";
 }
 
 /// @brief Checks if a file is a CSV file
@@ -71,134 +94,766 @@ class WaveEquationSolver {
 public:
     /// @enum Scheme
     /// @brief Enumeration of available numerical schemes
-    enum Scheme { E_FTBS, I_FTBS, Lax_Wendroff, Richtmyer_MultiStep, data, All };
+    enum Scheme { E_FTBS, I_FTBS, Lax_Wendroff, Richtmyer_MultiStep, BTCS, Crank_Nicolson, data, All };
 
     double dt; ///< Time step size
     double dx; ///< Spatial step size
     std::vector<std::vector<double>> matrix; ///< Matrix to store solution over time
+    RunInfo matrixGrid; ///< Grid of the rows of `matrix` (the finest grid after a refined solve)
     Input input; ///< Input parameters
+    int threads = 1; ///< Threads sharing the spatial domain of one solve
+    int blockLevels = 1; ///< Time levels advanced per tile by the explicit schemes (1: no blocking)
+    int blockTile = 2048; ///< Tile width in points for temporal blocking
+    bool simd = false; ///< Serial solves use the explicit SIMD kernels
+    bool simdFloat32 = false; ///< SIMD solves step in single precision
+    SimdISA simdISA = SimdISA::Scalar; ///< Instruction set of the SIMD kernels
+    TridiagonalCache bandedCache; ///< Factorisations of the implicit schemes, reused while dt and dx do not change
+    TimeControl timeControl; ///< Time-stepping strategy (Legacy by default)
+    std::string checkpointFile; ///< Checkpoint file ("" disables checkpointing)
+    int checkpointEvery = 0; ///< Levels between two checkpoints
+    bool checkpointResume = false; ///< Resume from a matching checkpoint when one exists
+    Refinement refinement; ///< Mesh refinement of the explicit schemes (levels = 0: uniform grid)
+    RefinementStats refinementStats; ///< Work of the last refined solve
+
+    /// @brief Minimum number of points per thread for domain decomposition
+    static const int MIN_POINTS_PER_THREAD = 16384;
 
     /// @brief Constructor to initialize the solver with input parameters
     /// @param input Input parameters for the simulation
     WaveEquationSolver(Input input) : input(input) {
         this->dx = (input.x_max - input.x_min) / input.N;
         this->dt = input.CFL * dx / input.u;
+        matrixGrid.N = input.N;
+        matrixGrid.dx = dx;
+        matrixGrid.x_min = input.x_min;
+        matrixGrid.dt = dt;
     }
 
     /// @brief Writes the solution matrix to a CSV file
     /// @param filename The name of the output CSV file
-    void writeMatixToCSV(std::string filename) {
+    /// @param precision Significant digits, or CSVWriter::SHORTEST for round-trip output
+    void writeMatixToCSV(std::string filename, int precision = 6) {
+        PROFILE_SCOPE("write_csv");
         if (is_csv(filename)) {
-            std::ofstream out(filename);
-            if (out.is_open()) {
-                out << "x, t, f\n";
-                for (int i = 0; i < matrix.size(); i++) {
-                    for (int j = 0; j < matrix[i].size(); j++) {
-                        double x = input.x_min + j * dx;
-                        out << x << ", " << i * dt << ", " << matrix[i][j] << "\n";
-                    }
+            CSVWriter writer(precision);
+            if (writer.open(filename)) {
+                writer.setColumns(matrixGrid.x_min, matrixGrid.dx, matrixGrid.N);
+                for (size_t i = 0; i < matrix.size(); i++) {
+                    writer.writeRow(i * matrixGrid.dt, matrix[i].data(), static_cast<int>(matrix[i].size()));
                 }
             }
-            out.close();
+            writer.close();
         } else {
             std::cerr << "Error opening file: " << filename << std::endl;
         }
     }
 
-    /// @brief Solves the wave equation using the explicit FTBS scheme
-    /// @param filename The name of the output CSV file
-    void solve_E_FTBS(const std::string& filename = "") {
-        matrix.clear();
-        std::vector<double> row;
+    /// @brief Returns the name of a scheme as used in result file names
+    /// @param scheme The scheme
+    /// @return "E_FTBS", "I_FTBS", "LW", "Richtmyer", "BTCS", "CN" or "UNKNOWN"
+    static std::string schemeName(Scheme scheme) {
+        switch (scheme) {
+        case E_FTBS: return "E_FTBS";
+        case I_FTBS: return "I_FTBS";
+        case Lax_Wendroff: return "LW";
+        case Richtmyer_MultiStep: return "Richtmyer";
+        case BTCS: return "BTCS";
+        case Crank_Nicolson: return "CN";
+        default: return "UNKNOWN";
+        }
+    }
 
-        for (int i = 0; i < input.N; i++) {
-            double x = input.x_min + i * dx;
-            row.push_back(input.bondary.t0_function(x));
+    /// @brief Number of time steps taken by a scheme after the initial level
+    /// @param scheme The scheme
+    /// @return Legacy: the step count of the historical `for (t = dt; t < t_max; t += dt)`
+    ///         loops. Exact: the integer steps reaching t_max without snapshots.
+    ///         Adaptive: an estimate at the CFL ceiling (the actual count depends on
+    ///         the stops and the error control).
+    int stepCount(Scheme scheme) const {
+        if (timeControl.mode == TimeControl::Exact) {
+            return TimeGrid(input.t_max, dt).steps();
+        }
+        if (timeControl.mode == TimeControl::Adaptive) {
+            const double ceiling = adaptiveLimit(scheme) * timeControl.safety;
+            return TimeGrid(input.t_max, std::isfinite(ceiling) ? ceiling : dt).steps();
         }
-        matrix.push_back(row);
+        double limit = (scheme == E_FTBS) ? input.t_max + dt : input.t_max;
+        int steps = 0;
+        for (double t = dt; t < limit; t += dt) {
+            steps++;
+        }
+        return steps;
+    }
 
-        for (double t = dt; t < input.t_max+dt; t += dt) {
-            for (int i = 1; i < input.N; i++) {
-                double x = input.x_min + i * dx;
-                row[i] = Explicit_Schemes::FTBS_alternative(x, dx, dt, input.u, matrix.back(), i);
-            }
-            matrix.push_back(row);
+    /// @brief Describes a run of this solver for output sinks
+    /// @param scheme The scheme
+    /// @return The run description
+    RunInfo runInfo(Scheme scheme) const {
+        RunInfo info;
+        info.scheme = schemeName(scheme);
+        info.bondary = bondaryName(input.bondary);
+        info.N = input.N;
+        info.dt = dt;
+        info.dx = dx;
+        info.x_min = input.x_min;
+        info.CFL = input.CFL;
+        info.u = input.u;
+        info.steps = stepCount(scheme);
+        if (refinement.levels > 0 && refinable(scheme)) {
+            // Refined solves record their levels on the grid of the finest level
+            info.N = refinement.outputPoints(input.N);
+            info.dx = dx / refinement.scale();
         }
+        return info;
+    }
 
-        writeMatixToCSV(filename);
+    /// @brief Splits every solve over several threads, each owning a chunk of the domain
+    /// @param count Number of threads (1: serial)
+    /// @note Results are bit-identical to the serial solver
+    void setThreads(int count) {
+        threads = std::max(1, count);
     }
 
-    /// @brief Solves the wave equation using the implicit FTBS scheme
-    /// @param filename The name of the output CSV file
-    void solve_I_FTBS(const std::string& filename = "") {
-        matrix.clear();
-        std::vector<double> row;
+    /// @brief Enables temporal blocking of E_FTBS and Lax-Wendroff in serial solves
+    /// @param levels Time levels advanced per tile (1 disables blocking)
+    /// @param tile Tile width in points
+    /// @note Only levels that are recorded are materialised as full rows, so the
+    ///       gain depends on recording every k-th level with k >= levels (or only
+    ///       snapshots). Results are bit-identical to the level-by-level loop.
+    void setTemporalBlocking(int levels, int tile = 2048) {
+        blockLevels = std::max(1, levels);
+        blockTile = tile;
+    }
+
+    /// @brief Steps serial solves with the hand-vectorised kernels on padded rows
+    /// @param enabled Whether to use the SIMD kernels
+    /// @param float32 Step in single precision (rows are widened to double for the sinks)
+    /// @param isa Instruction set; unsupported sets fall back to scalar
+    /// @note In double precision results are bit-identical to the default path.
+    ///       Temporal blocking does not apply to SIMD solves.
+    void setSimd(bool enabled, bool float32 = false, SimdISA isa = simdBest()) {
+        simd = enabled;
+        simdFloat32 = float32;
+        simdISA = isa;
+    }
+
+    /// @brief Chooses how the time levels are placed
+    /// @param control Legacy (default), Exact or Adaptive time stepping
+    /// @note Exact and Adaptive solves run serially on the level-by-level loop
+    ///       (no SIMD, blocking or domain decomposition).
+    void setTimeControl(const TimeControl& control) {
+        timeControl = control;
+    }
+
+    /// @brief Writes periodic checkpoints of the live row and resumes from them
+    /// @param filename The checkpoint file ("" disables checkpointing)
+    /// @param every Levels between two checkpoints
+    /// @param resume Continue from the checkpoint when it belongs to the same run
+    /// @note Checkpoints are written by a background thread (Tools/Checkpoint.cpp);
+    ///       the stepping loop only copies the row, once every `every` levels. A
+    ///       resumed solve is bit-identical to an uninterrupted one and sends its
+    ///       sink the recorded levels after the checkpoint. A completed solve deletes
+    ///       its checkpoint, so only interrupted runs resume. Applies to Legacy time
+    ///       control; a threaded SPIKE solve is not bit-identical to a serial one,
+    ///       so only resume it with the same thread count.
+    void setCheckpoint(const std::string& filename, int every, bool resume = true) {
+        checkpointFile = filename;
+        checkpointEvery = std::max(1, every);
+        checkpointResume = resume;
+    }
+
+    /// @brief Refines the grid around fronts and steep gradients (block-structured AMR)
+    /// @param settings Levels, ratio, indicator, threshold and regrid interval (levels = 0: uniform grid)
+    /// @note Applies to E_FTBS, Lax-Wendroff and Richtmyer (Tools/Refinement.cpp). The
+    ///       base grid has the N points of the input and every level steps at the same
+    ///       Courant number with subcycling. Recorded levels are the steps of the base
+    ///       grid, written on the grid of the finest level: (N - 1) * ratio^levels + 1
+    ///       points spaced dx / ratio^levels. Refined solves run serially with Legacy
+    ///       time control (no SIMD, blocking, domain decomposition or checkpoints).
+    void setRefinement(const Refinement& settings) {
+        refinement = settings;
+    }
+
+    /// @brief Whether a scheme supports mesh refinement
+    static bool refinable(Scheme scheme) {
+        return scheme == E_FTBS || scheme == Lax_Wendroff || scheme == Richtmyer_MultiStep;
+    }
+
+    /// @brief Header identifying the checkpoints of a run
+    /// @param scheme The scheme
+    /// @return The header at level 0
+    CheckpointHeader checkpointHeader(Scheme scheme) const {
+        CheckpointHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        header.version = 1;
+        header.value_size = sizeof(double);
+        std::strncpy(header.scheme, schemeName(scheme).c_str(), sizeof(header.scheme) - 1);
+        std::strncpy(header.bondary, bondaryName(input.bondary).c_str(), sizeof(header.bondary) - 1);
+        header.u = input.u;
+        header.L = input.L;
+        header.x_min = input.x_min;
+        header.x_max = input.x_max;
+        header.t_max = input.t_max;
+        header.N = input.N;
+        header.CFL = input.CFL;
+        header.dt = dt;
+        header.dx = dx;
+        header.steps = stepCount(scheme);
+        header.data_offset = sizeof(CheckpointHeader);
+        return header;
+    }
 
+    /// @brief Largest stable Courant number of a scheme
+    /// @return 1 for E_FTBS and Lax-Wendroff, 2 for Richtmyer (a Lax-Wendroff step
+    ///         on the 2 dx grid), infinity for the implicit schemes
+    static double stabilityLimit(Scheme scheme) {
+        switch (scheme) {
+        case E_FTBS: return 1.0;
+        case Lax_Wendroff: return 1.0;
+        case Richtmyer_MultiStep: return 2.0;
+        default: return std::numeric_limits<double>::infinity();
+        }
+    }
+
+    /// @brief Order of accuracy in time of a scheme (for the adaptive error model)
+    static int temporalOrder(Scheme scheme) {
+        return (scheme == Lax_Wendroff || scheme == Richtmyer_MultiStep || scheme == Crank_Nicolson) ? 2 : 1;
+    }
+
+    /// @brief Range of points a scheme updates; the other points keep their initial value
+    /// @param scheme The scheme
+    /// @param begin First updated index
+    /// @param end One past the last updated index
+    void updateRange(Scheme scheme, int& begin, int& end) const {
+        const int N = input.N;
+        switch (scheme) {
+        case E_FTBS: begin = 1; end = N; break;
+        case I_FTBS: begin = 2; end = N - 1; break;
+        case Lax_Wendroff: begin = 2; end = N - 2; break;
+        case Richtmyer_MultiStep: begin = 1; end = N - 2; break;
+        case BTCS: begin = 1; end = N - 1; break;
+        case Crank_Nicolson: begin = 1; end = N - 1; break;
+        default: begin = 0; end = 0; break;
+        }
+        end = std::max(begin, end);
+    }
+
+    /// @brief Exact solution of this run: the initial profile advected by u * t
+    /// @return Callable for NormSink error norms
+    NormSink::Exact exactSolution() const {
+        return NormSink::advected(input.bondary.t0_function, input.u);
+    }
+
+    /// @brief Evaluates the initial condition on the grid
+    /// @return The level at t = 0
+    std::vector<double> initialRow() const {
+        PROFILE_SCOPE("initial_condition");
+        std::vector<double> row(input.N);
         for (int i = 0; i < input.N; i++) {
             double x = input.x_min + i * dx;
-            row.push_back(input.bondary.t0_function(x));
+            row[i] = input.bondary.t0_function(x);
+        }
+        return row;
+    }
+
+    /// @brief Solves the wave equation keeping only the rows the scheme needs
+    /// @param scheme The scheme to use
+    /// @param sink Receives every recorded time level
+    /// @param policy Selects the recorded levels
+    /// @note Peak memory is O(N) regardless of the number of steps
+    void solve(Scheme scheme, RowSink& sink, const RecordPolicy& policy = RecordPolicy()) {
+        if (scheme < E_FTBS || scheme > Crank_Nicolson) {
+            std::cerr << "Error: unsupported scheme " << scheme << std::endl;
+            return;
+        }
+        PROFILE_SCOPE("solve");
+
+        RunInfo info = runInfo(scheme);
+        if (refinement.levels > 0) {
+            if (!refinable(scheme) || timeControl.mode != TimeControl::Legacy) {
+                std::cerr << "Error: mesh refinement needs E_FTBS, Lax-Wendroff or Richtmyer with Legacy time control" << std::endl;
+                return;
+            }
+            sink.begin(info);
+            solveRefined(scheme, policy, info, sink);
+            sink.end();
+            return;
+        }
+        if (timeControl.mode != TimeControl::Legacy) {
+            sink.begin(info);
+            solveControlled(scheme, policy, sink);
+            sink.end();
+            return;
+        }
+        const int steps = info.steps;
+        const int N = input.N;
+        const SchemeCoefficients k = SchemeCoefficients::make(dx, dt, input.u);
+        const RecordSchedule recorded(policy, dt, steps);
+        int begin, end;
+        updateRange(scheme, begin, end);
+
+        // With checkpoints the loops also stop at the checkpoint levels, and the
+        // CheckpointSink sorts them out; a resumed run starts from the stored row
+        const bool checkpointing = !checkpointFile.empty();
+        const CheckpointHeader header = checkpointing ? checkpointHeader(scheme) : CheckpointHeader();
+        int first = 0;
+        std::vector<double> start;
+        if (checkpointing && checkpointResume) {
+            CheckpointHeader stored;
+            if (readCheckpoint(checkpointFile, stored, start)) {
+                if (sameRun(stored, header) && stored.level >= 0 && stored.level < steps) {
+                    first = static_cast<int>(stored.level);
+                } else if (sameRun(stored, header) && stored.level == steps) {
+                    // Left behind by a completed run: there is nothing to resume
+                } else {
+                    std::cerr << "Error: checkpoint " << checkpointFile << " belongs to another run, starting from t = 0" << std::endl;
+                }
+            }
         }
-        matrix.push_back(row);
+        if (first == 0) start = initialRow();
+        const RecordSchedule schedule(policy, dt, steps, checkpointing ? checkpointEvery : 0);
+        std::unique_ptr<CheckpointWriter> writer(checkpointing ? new CheckpointWriter(checkpointFile) : nullptr);
+        std::unique_ptr<CheckpointSink> wrapper(
+            checkpointing ? new CheckpointSink(sink, recorded, *writer, header, checkpointEvery, first) : nullptr);
+        RowSink& target = checkpointing ? static_cast<RowSink&>(*wrapper) : sink;
 
-        for (double t = dt; t < input.t_max; t += dt) {
-            for (int i = input.N - 2; i > 1; i--) {
-                double x = input.x_min + i * dx;
-                row[i] = Implicit_Schemes::I_FTBS_alternative(x, dx, dt, input.u, row[i - 1], matrix.back(), i);
+        int parts = std::min(threads, (end - begin) / MIN_POINTS_PER_THREAD);
+        sink.begin(info);
+        PROFILE_COUNT("points_updated", static_cast<long long>(end - begin) * (steps - first));
+        {
+            PROFILE_SCOPE("stepping"); // Self time: the schemes alone, the sinks have their own scopes
+            if (scheme == BTCS || scheme == Crank_Nicolson) {
+                std::vector<double> b = start;
+                solveBanded(scheme, k, schedule, first, steps, begin, end, std::max(1, parts), start, b, target);
+            } else if (parts > 1) {
+                // Both buffers start from the same level so points a scheme never
+                // updates keep their initial value whichever buffer is current
+                std::vector<double> b = start;
+                std::vector<double> half = start;
+                solveDecomposed(scheme, k, schedule, first, steps, begin, end, parts, start, b, half, target);
+            } else {
+                EngineRun run;
+                run.N = N;
+                run.x_min = input.x_min;
+                run.dx = dx;
+                run.dt = dt;
+                run.steps = steps;
+                run.k = k;
+                run.schedule = &schedule;
+                run.left = input.bondary.left;
+                run.right = input.bondary.right;
+                run.t0_function = input.bondary.t0_function;
+                run.blockLevels = blockLevels;
+                run.blockTile = blockTile;
+                run.first = first;
+                run.start = (first > 0) ? start.data() : nullptr;
+                if (simd) {
+                    static const SimdStencil stencils[4] = {SimdStencil::FTBS, SimdStencil::Implicit_FTBS,
+                                                            SimdStencil::Lax_Wendroff, SimdStencil::Richtmyer};
+                    if (simdFloat32) {
+                        SimdEngine<float>::run(simdISA, stencils[scheme], run, start, begin, end, target);
+                    } else {
+                        SimdEngine<double>::run(simdISA, stencils[scheme], run, start, begin, end, target);
+                    }
+                } else {
+                    engine(scheme, input.bondary)(run, target);
+                }
             }
-            matrix.push_back(row);
         }
+        if (writer) {
+            // The run is complete: a later solve of the same run starts from t = 0
+            writer->flush();
+            writer.reset();
+            std::remove(checkpointFile.c_str());
+        }
+        sink.end();
+    }
+
+    /// @brief Registry mapping a scheme and an initial condition to its compiled engine
+    /// @param scheme The scheme
+    /// @param bondary The boundary set; SET1 and SET2 get fully inlined initial conditions
+    /// @return The engine instantiation, or nullptr for an unsupported scheme
+    static EngineRunner engine(Scheme scheme, const Bondary& bondary) {
+        typedef FunctionInitial<double (*)(double)> AnyInitial;
+        static const EngineRunner table[4][3] = {
+            {SchemeEngine<FTBSStencil, Set1Initial>::runDefault, SchemeEngine<FTBSStencil, Set2Initial>::runDefault,
+             SchemeEngine<FTBSStencil, AnyInitial>::runDefault},
+            {SchemeEngine<ImplicitFTBSStencil, Set1Initial>::runDefault, SchemeEngine<ImplicitFTBSStencil, Set2Initial>::runDefault,
+             SchemeEngine<ImplicitFTBSStencil, AnyInitial>::runDefault},
+            {SchemeEngine<LaxWendroffStencil, Set1Initial>::runDefault, SchemeEngine<LaxWendroffStencil, Set2Initial>::runDefault,
+             SchemeEngine<LaxWendroffStencil, AnyInitial>::runDefault},
+            {SchemeEngine<RichtmyerStencil, Set1Initial>::runDefault, SchemeEngine<RichtmyerStencil, Set2Initial>::runDefault,
+             SchemeEngine<RichtmyerStencil, AnyInitial>::runDefault},
+        };
+        if (scheme < E_FTBS || scheme > Richtmyer_MultiStep) {
+            return nullptr;
+        }
+        int initial = (bondary.t0_function == SET1_Function) ? 0 : (bondary.t0_function == SET2_Function) ? 1 : 2;
+        return table[scheme][initial];
+    }
+
+    /// @brief Solves the wave equation streaming the recorded levels to a callback
+    /// @param scheme The scheme to use
+    /// @param callback Called with (level, t, row, n) for every recorded level
+    /// @param policy Selects the recorded levels
+    void solve(Scheme scheme, const CallbackSink::Callback& callback, const RecordPolicy& policy = RecordPolicy()) {
+        CallbackSink sink(callback);
+        solve(scheme, sink, policy);
+    }
 
+    /// @brief Solves the wave equation storing every level in `matrix`
+    /// @param scheme The scheme to use
+    /// @param filename The name of the output CSV file
+    void solveToMatrix(Scheme scheme, const std::string& filename) {
+        matrix.clear();
+        matrixGrid = runInfo(scheme);
+        solve(scheme, [this](int level, double t, const double* row, int n) {
+            PROFILE_SCOPE("matrix_push_back");
+            PROFILE_COUNT("allocations", 1 + (matrix.size() == matrix.capacity())); // The row, plus the growth of matrix
+            matrix.emplace_back(row, row + n);
+        });
         writeMatixToCSV(filename);
     }
 
+    /// @brief Solves the wave equation using the explicit FTBS scheme
+    /// @param filename The name of the output CSV file
+    void solve_E_FTBS(const std::string& filename = "") {
+        solveToMatrix(E_FTBS, filename);
+    }
+
+    /// @brief Solves the wave equation using the implicit FTBS scheme
+    /// @param filename The name of the output CSV file
+    void solve_I_FTBS(const std::string& filename = "") {
+        solveToMatrix(I_FTBS, filename);
+    }
+
     /// @brief Solves the wave equation using the Lax-Wendroff scheme
     /// @param filename The name of the output CSV file
     void solve_Lax_Wendroff(const std::string& filename = "") {
-        matrix.clear();
-        std::vector<double> row;
+        solveToMatrix(Lax_Wendroff, filename);
+    }
 
-        for (int i = 0; i < input.N; i++) {
-            double x = input.x_min + i * dx;
-            row.push_back(input.bondary.t0_function(x));
+    /// @brief Solves the wave equation using the Richtmyer multistep scheme
+    /// @param filename The name of the output CSV file
+    void solve_Richtmyer_MultiStep(const std::string& filename = "") {
+        solveToMatrix(Richtmyer_MultiStep, filename);
+    }
+
+    /// @brief Solves the wave equation using the implicit BTCS scheme
+    /// @param filename The name of the output CSV file
+    void solve_BTCS(const std::string& filename = "") {
+        solveToMatrix(BTCS, filename);
+    }
+
+    /// @brief Solves the wave equation using the Crank-Nicolson scheme
+    /// @param filename The name of the output CSV file
+    void solve_Crank_Nicolson(const std::string& filename = "") {
+        solveToMatrix(Crank_Nicolson, filename);
+    }
+
+private:
+    /// @brief Right-hand side of the implicit unknowns [lo, hi) of [begin, end), boundary terms included
+    static void implicitRhs(Scheme scheme, const SchemeCoefficients& k, const double* prev, double* next, int lo, int hi,
+                            int begin, int end) {
+        const double off = (scheme == BTCS) ? k.bt_implicit : k.cn_implicit;
+        if (scheme == BTCS) {
+            std::copy(prev + lo, prev + hi, next + lo);
+        } else {
+            Row_Schemes::Crank_Nicolson_rhs(k, prev, next, lo, hi);
         }
-        matrix.push_back(row);
+        if (lo == begin) next[begin] += off * prev[begin - 1];
+        if (hi == end) next[end - 1] -= off * prev[end];
+    }
 
-        for (double t = dt; t < input.t_max; t += dt) {
-            for (int i = 2; i < input.N - 2; i++) {
-                double x = input.x_min + i * dx;
-                row[i] = Explicit_Schemes::Lax_Wendroff(x, dx, dt, input.u, matrix.back(), i);
+    /// @brief Advances one level of any scheme with the given coefficients
+    /// @note Two-row schemes swap current and spare; the others update current in place
+    void advance(Scheme scheme, const SchemeCoefficients& k, double*& current, double*& spare, double* half, int begin, int end) {
+        switch (scheme) {
+        case E_FTBS: FTBSStencil::step(k, current, spare, half, begin, end); break;
+        case I_FTBS: ImplicitFTBSStencil::step(k, current, spare, half, begin, end); break;
+        case Lax_Wendroff: LaxWendroffStencil::step(k, current, spare, half, begin, end); break;
+        case Richtmyer_MultiStep: RichtmyerStencil::step(k, current, spare, half, begin, end); break;
+        case BTCS:
+        case Crank_Nicolson:
+            if (end > begin) {
+                const double off = (scheme == BTCS) ? k.bt_implicit : k.cn_implicit;
+                implicitRhs(scheme, k, current, spare, begin, end, begin, end);
+                bandedCache.thomas(end - begin, -off, 1.0, off).solve(spare + begin);
+                std::swap(current, spare);
             }
-            matrix.push_back(row);
+            break;
+        default: break;
         }
+    }
 
-        writeMatixToCSV(filename);
+    /// @brief CFL ceiling of the adaptive mode as a step: maxCFL, else the stability
+    ///        limit, else (implicit schemes without error control) the input CFL
+    double adaptiveLimit(Scheme scheme) const {
+        double ceiling = (timeControl.maxCFL > 0) ? timeControl.maxCFL : stabilityLimit(scheme);
+        if (!std::isfinite(ceiling) && timeControl.tolerance <= 0) ceiling = input.CFL;
+        return ceiling * dx / input.u;
     }
 
-    /// @brief Solves the wave equation using the Richtmyer multistep scheme
-    /// @param filename The name of the output CSV file
-    void solve_Richtmyer_MultiStep(const std::string& filename = "") {
-        matrix.clear();
-        std::vector<double> row, row_half;
+    /// @brief Stepping loop of the Exact and Adaptive time controls
+    /// @note Levels are counted in integer steps and the time of a level that
+    ///       reaches a stop (snapshot time or t_max) is the stop itself.
+    void solveControlled(Scheme scheme, const RecordPolicy& policy, RowSink& sink) {
+        const int N = input.N;
+        const double t_max = input.t_max;
+        int begin, end;
+        updateRange(scheme, begin, end);
+        std::vector<double> a = initialRow();
+        std::vector<double> b = a;
+        std::vector<double> half = a;
+        double* current = a.data();
+        double* spare = b.data();
+        int level = 0;
+        if (recordedAt(policy, 0, 0.0, t_max)) {
+            sink.write(0, 0.0, current, N);
+        }
 
-        for (int i = 0; i < input.N; i++) {
-            double x = input.x_min + i * dx;
-            row.push_back(input.bondary.t0_function(x));
+        if (timeControl.mode == TimeControl::Exact) {
+            TimeGrid grid(t_max, dt, policy.snapshot_times);
+            for (const TimeGrid::Segment& segment : grid.segments) {
+                const SchemeCoefficients k = SchemeCoefficients::make(dx, segment.dt(), input.u);
+                for (int j = 1; j <= segment.steps; j++) {
+                    advance(scheme, k, current, spare, half.data(), begin, end);
+                    level++;
+                    const double t = segment.time(j);
+                    if (recordedAt(policy, level, t, t_max)) {
+                        sink.write(level, t, current, N);
+                    }
+                }
+            }
+            return;
+        }
+
+        // Adaptive: with error control, each attempt also takes two half steps from
+        // the same level; the half-step result is kept when the step is accepted
+        // Error-controlled runs start from the nominal dt and grow from there
+        const double limit = adaptiveLimit(scheme);
+        StepController controller(timeControl, limit, (timeControl.tolerance > 0) ? std::min(dt, limit) : limit,
+                                  temporalOrder(scheme));
+        std::vector<double> fullA, fullB, halfA, halfB;
+        double t = 0;
+        for (double stop : TimeGrid::stopsOf(t_max, policy.snapshot_times)) {
+            while (t < stop) {
+                bool lands = false;
+                const double step = controller.propose(t, stop, lands);
+                const SchemeCoefficients k = SchemeCoefficients::make(dx, step, input.u);
+                if (controller.controlled()) {
+                    fullA.assign(current, current + N);
+                    fullB = fullA;
+                    halfA = fullA;
+                    halfB = fullA;
+                    double* full = fullA.data();
+                    double* fullSpare = fullB.data();
+                    advance(scheme, k, full, fullSpare, half.data(), begin, end);
+                    const SchemeCoefficients k2 = SchemeCoefficients::make(dx, step / 2, input.u);
+                    double* halves = halfA.data();
+                    double* halvesSpare = halfB.data();
+                    advance(scheme, k2, halves, halvesSpare, half.data(), begin, end);
+                    advance(scheme, k2, halves, halvesSpare, half.data(), begin, end);
+                    double difference = 0;
+                    for (int i = 0; i < N; i++) {
+                        difference = std::max(difference, std::fabs(full[i] - halves[i]));
+                    }
+                    if (!controller.judge(step, difference)) continue;
+                    std::copy(halves, halves + N, current);
+                } else {
+                    advance(scheme, k, current, spare, half.data(), begin, end);
+                }
+                t = lands ? stop : t + step;
+                level++;
+                if (recordedAt(policy, level, t, t_max)) {
+                    sink.write(level, t, current, N);
+                }
+            }
+        }
+    }
+
+    /// @brief Stepping loop of the refined solves
+    void solveRefined(Scheme scheme, const RecordPolicy& policy, const RunInfo& info, RowSink& sink) {
+        const RecordSchedule schedule(policy, dt, info.steps);
+        EngineRun run;
+        run.N = input.N;
+        run.x_min = input.x_min;
+        run.dx = dx;
+        run.dt = dt;
+        run.steps = info.steps;
+        run.k = SchemeCoefficients::make(dx, dt, input.u);
+        run.schedule = &schedule;
+        run.left = input.bondary.left;
+        run.right = input.bondary.right;
+        run.t0_function = input.bondary.t0_function;
+        run.blockLevels = 1;
+        run.blockTile = blockTile;
+
+        PROFILE_SCOPE("stepping");
+        switch (scheme) {
+        case E_FTBS: solveRefinedWith<FTBSStencil>(run, sink); break;
+        case Lax_Wendroff: solveRefinedWith<LaxWendroffStencil>(run, sink); break;
+        case Richtmyer_MultiStep: solveRefinedWith<RichtmyerStencil>(run, sink); break;
+        default: break;
         }
-        matrix.push_back(row);
-        row_half = row;
+        PROFILE_COUNT("points_updated", refinementStats.pointsUpdated);
+    }
+
+    /// @brief Runs the refined engine of one stencil and keeps its statistics
+    template <class Stencil>
+    void solveRefinedWith(const EngineRun& run, RowSink& sink) {
+        RefinedEngine<Stencil> engine(run, refinement);
+        engine.solve(sink);
+        refinementStats = engine.statistics();
+    }
+
+    /// @brief Stepping loop of the implicit central schemes (BTCS, Crank-Nicolson)
+    /// @note Each step builds the right-hand side from the current level into the
+    ///       spare row and solves the tridiagonal system for the interior points in
+    ///       place; the end points keep their initial value and enter the first and
+    ///       last rows as known terms. The factorisation comes from bandedCache. With
+    ///       several parts the system is solved by SPIKE on persistent workers, each
+    ///       owning one partition (right-hand side, local solve and correction), with
+    ///       worker 0 solving the reduced system between two barriers.
+    void solveBanded(Scheme scheme, const SchemeCoefficients& k, const RecordSchedule& schedule, int first, int steps,
+                     int begin, int end, int parts, std::vector<double>& a, std::vector<double>& b, RowSink& sink) {
+        const int N = input.N;
+        const int n = end - begin;
+        const double off = (scheme == BTCS) ? k.bt_implicit : k.cn_implicit;
+        double* current = a.data();
+        double* spare = b.data();
+
+        auto rhs = [&](const double* prev, double* next, int lo, int hi) {
+            implicitRhs(scheme, k, prev, next, lo, hi, begin, end);
+        };
 
-        for (double t = dt; t < input.t_max; t += dt) {
-            for (int i = 1; i < input.N - 2; i++) {
-                double x = input.x_min + i * dx;
-                row_half[i] = Step_Schemes::Ritchmyer_method_prediction(x, dx, dt, input.u, matrix.back(), i);
+        if (parts <= 1 || n <= 0) {
+            const TridiagonalLU& lu = bandedCache.thomas(n, -off, 1.0, off);
+            for (int level = first; level <= steps; level++) {
+                if (level > first && n > 0) {
+                    rhs(current, spare, begin, end);
+                    lu.solve(spare + begin);
+                    std::swap(current, spare);
+                }
+                if (schedule.at(level)) {
+                    sink.write(level, level * dt, current, N);
+                }
             }
-            for (int i = 1; i < input.N - 2; i++) {
-                double x = input.x_min + i * dx;
-                row[i] = Step_Schemes::Ritchmyer_method_correction(x, dx, dt, input.u, matrix.back(), row_half, i);
+            return;
+        }
+
+        SpikeTridiagonal& spike = bandedCache.spike(n, -off, 1.0, off, parts);
+        parts = spike.partitions();
+        SpinBarrier barrier(parts);
+        auto work = [&](int p) {
+            const int lo = begin + spike.first(p);
+            const int hi = begin + ((p + 1 < parts) ? spike.first(p + 1) : n);
+            double* cur = a.data();
+            double* next = b.data();
+            for (int level = first; level <= steps; level++) {
+                if (level > first) {
+                    rhs(cur, next, lo, hi);
+                    spike.local(p, next + begin);
+                    barrier.wait();
+                    if (p == 0) spike.reduce(next + begin);
+                    barrier.wait();
+                    spike.correct(p, next + begin);
+                    std::swap(cur, next);
+                    barrier.wait();
+                }
+                // Nobody writes the recorded row before the next barrier of the next step
+                if (p == 0 && schedule.at(level)) {
+                    sink.write(level, level * dt, cur, N);
+                }
             }
-            matrix.push_back(row);
+        };
+
+        std::vector<std::thread> workers;
+        for (int p = 1; p < parts; p++) {
+            workers.emplace_back(work, p);
         }
+        work(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
 
-        writeMatixToCSV(filename);
+    /// @brief Stepping loop with the domain split over persistent worker threads
+    /// @note Each worker owns [bounds[p], bounds[p + 1]) for the whole run and a
+    ///       spin barrier separates the steps. The explicit schemes read their
+    ///       neighbours straight from the shared previous row. The implicit FTBS
+    ///       sweep reads row[i - 1] before it is overwritten, so each worker
+    ///       publishes the old value of its last point in a per-step halo slot
+    ///       (alternating by step parity) that its right neighbour uses for its
+    ///       first point. Worker 0 is the calling thread and feeds the sink.
+    void solveDecomposed(Scheme scheme, const SchemeCoefficients& k, const RecordSchedule& schedule, int first, int steps,
+                         int begin, int end, int parts, std::vector<double>& a, std::vector<double>& b,
+                         std::vector<double>& half, RowSink& sink) {
+        const int N = input.N;
+        const std::vector<int> bounds = splitRange(begin, end, parts);
+        const bool inPlace = (scheme == I_FTBS || scheme == Richtmyer_MultiStep);
+        SpinBarrier barrier(parts);
+
+        // halo[parity][p]: value of the last point of chunk p before the step
+        std::vector<double> halo[2] = {std::vector<double>(parts), std::vector<double>(parts)};
+        for (int p = 0; p < parts; p++) {
+            halo[(first + 1) & 1][p] = a[bounds[p + 1] - 1];
+        }
+
+        auto work = [&](int p) {
+            const int lo = bounds[p];
+            const int hi = bounds[p + 1];
+            double* current = a.data();
+            double* spare = b.data();
+            for (int level = first; level <= steps; level++) {
+                if (level > first) {
+                    switch (scheme) {
+                    case E_FTBS:
+                        Row_Schemes::FTBS(k, current, spare, lo, hi);
+                        std::swap(current, spare);
+                        break;
+                    case I_FTBS:
+                        if (hi > lo) {
+                            double last = (p == 0) ? current[lo - 1] : halo[level & 1][p - 1];
+                            Row_Schemes::I_FTBS(k, current, current, lo + 1, hi);
+                            current[lo] = Row_Schemes::I_FTBS_point(k, last, current, lo);
+                            halo[(level + 1) & 1][p] = current[hi - 1];
+                        }
+                        break;
+                    case Lax_Wendroff:
+                        Row_Schemes::Lax_Wendroff(k, current, spare, lo, hi);
+                        std::swap(current, spare);
+                        break;
+                    case Richtmyer_MultiStep:
+                        Row_Schemes::Richtmyer_prediction(k, current, half.data(), lo, hi);
+                        barrier.wait();
+                        Row_Schemes::Richtmyer_correction(k, current, half.data(), current, lo, hi);
+                        break;
+                    default:
+                        break;
+                    }
+                    barrier.wait();
+                }
+                if (schedule.at(level)) {
+                    if (p == 0) {
+                        sink.write(level, level * dt, current, N);
+                    }
+                    // In-place schemes overwrite the recorded row in the next step
+                    if (inPlace) {
+                        barrier.wait();
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int p = 1; p < parts; p++) {
+            workers.emplace_back(work, p);
+        }
+        work(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
     }
 };
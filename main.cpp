@@ -1,85 +1,160 @@
-#include <vector>
-#include <iostream>
-#include <string>
-#include <fstream>
-#include <cstdlib>
-#ifdef _WIN32
-#include <direct.h> // For _mkdir on Windows
-#else
-#include <sys/stat.h> // For mkdir on Linux/Mac
-#endif
-
-#include "./Tools/WaveEquationSolver.cpp" // Include the WaveEquationSolver implementation
-
-/// @brief Creates a folder in the file system
-/// @param folder Name of the folder to be created
-void createFolder(const std::string& folder) {
-#ifdef _WIN32
-    if (_mkdir(folder.c_str()) != 0) { // Create the folder (Windows)
-        perror("Error creating folder");
-    }
-#else
-    if (mkdir(folder.c_str(), 0777) != 0) { // Create the folder with permissions (Linux/Mac)
-        perror("Error creating folder");
-    }
-#endif
-}
-
-int main() {
-    // Create a folder to store results
-    std::string folder = "Results";
-    createFolder(folder);
-
-    // Simulation variables
-    double L = 100.0;    // Domain length
-    double u = 1.75;     // Advection velocity
-    double CFL = 0.5;     // Courant-Friedrichs-Lewy number
-
-    // Define boundary conditions
-    Bondary SET1_SIGN = {SET1_Function, 0, 1}; // SET1_SIGN: Step function with boundaries 0 and 1
-    Bondary SET2_EXP = {SET2_Function, 0, 0}; // SET2_EXP: Exponential function with boundaries 0 and 0
-
-    // Define values for time and spatial resolution
-    std::vector<int> t_values = {5,10};      // Different time durations
-    std::vector<int> N_values = {100, 200, 400}; // Different number of spatial points
-
-    // Store different input configurations
-    std::vector<Input> inputs;
-
-
-    for  (int n: N_values){
-        for (Bondary bondary : {SET1_SIGN, SET2_EXP}) {
-            Input input = {u, L, -L / 2, L / 2, t_values[1], n, CFL, bondary};
-            inputs.push_back(input); // Add input configuration to the list
-        }
-    }
-        
-
-    // Solve the wave equation for each input configuration
-    for (Input input : inputs) {
-        WaveEquationSolver solver(input);
-
-        // Determine the name of the boundary function for file naming
-        std::string bondary_name = (input.bondary.t0_function == SET1_Function) ? "SET1_sign" :
-                                   (input.bondary.t0_function == SET2_Function) ? "SET2_exp" :
-                                   "UNKNOWN";
-
-        // Solve using Explicit FTBS and write results to CSV
-        solver.solve_E_FTBS(folder + "/E_FTBS_" + bondary_name + "_" + 
-                            std::to_string(input.N) + "_" + std::to_string(input.t_max) + ".csv");
-
-        // Solve using Implicit FTBS and write results to CSV
-        solver.solve_I_FTBS(folder + "/I_FTBS_" + bondary_name + "_" + 
-                            std::to_string(input.N) + "_" + std::to_string(input.t_max) + ".csv");
-
-        // Solve using Lax-Wendroff and write results to CSV
-        solver.solve_Lax_Wendroff(folder + "/LW_" + bondary_name + "_" + 
-                                  std::to_string(input.N) + "_" + std::to_string(input.t_max) + ".csv");
-
-        // Solve using Richtmyer Multistep and write results to CSV
-        solver.solve_Richtmyer_MultiStep(folder + "/Richtmyer_" + bondary_name + "_" + 
-                                         std::to_string(input.N) + "_" + std::to_string(input.t_max) + ".csv");
-    }
-
-    return 0; // Exit program
-}
+#include <vector>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <sstream>
+#include <memory>
+#include <thread>
+#ifdef _WIN32
+#include <direct.h> // For _mkdir on Windows
+#else
+#include <sys/stat.h> // For mkdir on Linux/Mac
+#endif
+
+#include "./Tools/WaveEquationSolver.cpp" // Include the WaveEquationSolver implementation
+#include "./Tools/ResultFile.cpp" // Binary result format
+#include "./Tools/Sweep.cpp" // Parallel parameter sweeps
+#include "./Tools/AsyncSink.cpp" // Output on a writer thread
+#include "./Tools/Compression.cpp" // Compressed result format
+#include "./Tools/Pyramid.cpp" // Level-of-detail pyramid for the viz scripts
+
+/// @brief Creates a folder in the file system
+/// @param folder Name of the folder to be created
+void createFolder(const std::string& folder) {
+#ifdef _WIN32
+    if (_mkdir(folder.c_str()) != 0) { // Create the folder (Windows)
+        perror("Error creating folder");
+    }
+#else
+    if (mkdir(folder.c_str(), 0777) != 0) { // Create the folder with permissions (Linux/Mac)
+        perror("Error creating folder");
+    }
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    // Output options: binary .wes files by default, CSV as an optional export
+    bool writeCSV = false;
+    bool float32 = false;
+    bool errorNorms = false;
+    bool compress = false;
+    bool pyramid = false;
+    double tolerance = 0; // 0: lossless compression
+    int refine = 0; // Refined levels around the fronts (0: uniform grid)
+    unsigned threads = 0; // 0: one per hardware thread
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") {
+            writeCSV = true;
+        } else if (arg == "--float32") {
+            float32 = true;
+        } else if (arg == "--norms") {
+            errorNorms = true;
+        } else if (arg == "--lod") {
+            pyramid = true;
+        } else if (arg == "--compress") {
+            compress = true;
+        } else if (arg.rfind("--tolerance=", 0) == 0) {
+            compress = true;
+            tolerance = std::stod(arg.substr(12));
+        } else if (arg.rfind("--refine=", 0) == 0) {
+            refine = std::stoi(arg.substr(9));
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--csv] [--float32] [--norms] [--lod] [--compress] [--tolerance=E] [--refine=L] [--threads=K]" << std::endl;
+            return 1;
+        }
+    }
+    if (compress && float32) {
+        std::cerr << "--float32 and --compress are exclusive (use --tolerance=E for a lossy file)" << std::endl;
+        return 1;
+    }
+
+    // Create a folder to store results
+    std::string folder = "Results";
+    createFolder(folder);
+
+    // Define boundary conditions
+    Bondary SET1_SIGN = {SET1_Function, 0, 1}; // SET1_SIGN: Step function with boundaries 0 and 1
+    Bondary SET2_EXP = {SET2_Function, 0, 0}; // SET2_EXP: Exponential function with boundaries 0 and 0
+
+    // Parameter space: every combination is an independent job
+    SweepSpace space;
+    space.L = 100.0;                       // Domain length
+    space.u = {1.75};                      // Advection velocity
+    space.CFL = {0.5};                     // Courant-Friedrichs-Lewy number
+    space.t_max = {10};                    // Simulation time
+    space.N = {100, 200, 400};             // Different number of spatial points
+    space.bondaries = {SET1_SIGN, SET2_EXP};
+    space.schemes = {WaveEquationSolver::E_FTBS, WaveEquationSolver::I_FTBS,
+                     WaveEquationSolver::Lax_Wendroff, WaveEquationSolver::Richtmyer_MultiStep};
+
+    // Solve every job on the thread pool, streaming each time level to its
+    // result files so memory stays O(N) per job
+    std::vector<SweepJob> jobs = space.jobs();
+    std::string normsFolder = folder + "/NormsResult";
+    if (errorNorms) {
+        createFolder(normsFolder);
+    }
+    std::vector<std::string> summary(jobs.size());
+
+    // A writer thread per job only pays off on a core the sweep leaves free
+    const bool asyncOutput = threads > 0 && std::thread::hardware_concurrency() > threads;
+    SweepRunner runner(threads);
+    runner.run(jobs, [&](WaveEquationSolver& solver, SweepJob& job) {
+        PROFILE_SCOPE("job");
+        // File name: [Scheme]_[SET of Bondaries]_[N]_[Tmax]
+        std::string name = folder + "/" + job.name;
+
+        // Refined grid around the fronts (explicit schemes): the files hold the grid of
+        // the finest level, (N - 1) * 2^refine + 1 points
+        if (refine > 0 && WaveEquationSolver::refinable(job.scheme)) {
+            Refinement refinement;
+            refinement.levels = refine;
+            solver.setRefinement(refinement);
+        }
+
+        // Error against the advected initial profile, per level, computed in process
+        const std::vector<Norms::NormType> normTypes = {Norms::NormType::L1, Norms::NormType::L2,
+                                                        Norms::NormType::LInf, Norms::NormType::Lp};
+        NormSink norms(normTypes, 2.5, solver.exactSolution());
+
+        // Binary .wes file, or compressed .wez file (lossless, or within `tolerance` of every value)
+        std::unique_ptr<RowSink> binary(compress ? static_cast<RowSink*>(new CompressedSink(name + ".wez", tolerance))
+                                                 : new BinarySink(name + ".wes", float32));
+        std::unique_ptr<CSVSink> csv(writeCSV ? new CSVSink(name + ".csv") : nullptr);
+        std::unique_ptr<PyramidSink> lod(pyramid ? new PyramidSink(name + ".lod") : nullptr);
+        std::vector<RowSink*> sinks = {binary.get()};
+        if (csv) sinks.push_back(csv.get());
+        if (lod) sinks.push_back(lod.get());
+        if (errorNorms) sinks.push_back(&norms);
+        TeeSink tee(sinks);
+        // With a spare core the files are written by a writer thread while the solver steps on
+        std::unique_ptr<AsyncSink> async(asyncOutput ? new AsyncSink(tee) : nullptr);
+        solver.solve(job.scheme, async ? static_cast<RowSink&>(*async) : tee);
+
+        if (errorNorms) {
+            norms.writeTable(normsFolder + "/" + job.name + "_error.csv");
+            std::ostringstream line;
+            line << job.name << "," << WaveEquationSolver::schemeName(job.scheme) << "," << norms.run().N << ",";
+            norms.writeFields(line, norms.last());
+            summary[job.index] = line.str();
+        }
+    });
+
+    // Final-time error of every job in one compact table
+    if (errorNorms) {
+        std::ofstream out(normsFolder + "/ErrorNorms.csv");
+        out << "FileName,Scheme,Samples,L1,L2,LInf,Lp(p=2.5)\n";
+        for (const std::string& line : summary) {
+            out << line << "\n";
+        }
+    }
+
+    // Built with -DWES_PROFILE: per-phase times and counters, and a Chrome trace
+    PROFILE_REPORT(folder + "/profile.json", folder + "/trace.json");
+
+    return 0; // Exit program
+}
@@ -0,0 +1,460 @@
+import os
+import numpy as np
+import pandas as pd
+
+# Extensions of the result files written by main.cpp
+RESULT_EXTENSIONS = ('.wes', '.wez', '.csv')
+BINARY_EXTENSIONS = ('.wes', '.wez')
+
+# 256-byte header of a binary .wes result file (see Tools/ResultFile.cpp)
+HEADER_DTYPE = np.dtype([
+    ('magic', 'S8'),
+    ('version', '<u4'),
+    ('value_size', '<u4'),
+    ('scheme', 'S32'),
+    ('bondary', 'S32'),
+    ('N', '<i8'),
+    ('rows', '<i8'),
+    ('dt', '<f8'),
+    ('dx', '<f8'),
+    ('x_min', '<f8'),
+    ('CFL', '<f8'),
+    ('u', '<f8'),
+    ('data_offset', '<i8'),
+    ('table_offset', '<i8'),
+    ('reserved', 'V104'),
+])
+
+TABLE_DTYPE = np.dtype([('level', '<i8'), ('t', '<f8')])
+
+# 256-byte header of a compressed .wez result file (see Tools/Compression.cpp)
+COMPRESSED_HEADER_DTYPE = np.dtype([
+    ('magic', 'S8'),
+    ('version', '<u4'),
+    ('mode', '<u4'),
+    ('scheme', 'S32'),
+    ('bondary', 'S32'),
+    ('N', '<i8'),
+    ('rows', '<i8'),
+    ('dt', '<f8'),
+    ('dx', '<f8'),
+    ('x_min', '<f8'),
+    ('CFL', '<f8'),
+    ('u', '<f8'),
+    ('tolerance', '<f8'),
+    ('block_rows', '<i8'),
+    ('blocks', '<i8'),
+    ('index_offset', '<i8'),
+    ('table_offset', '<i8'),
+    ('reserved', 'V80'),
+])
+
+# 256-byte header of a level-of-detail .lod file and its level table (see Tools/Pyramid.cpp)
+LOD_HEADER_DTYPE = np.dtype([
+    ('magic', 'S8'),
+    ('version', '<u4'),
+    ('factor', '<u4'),
+    ('scheme', 'S32'),
+    ('bondary', 'S32'),
+    ('N', '<i8'),
+    ('rows', '<i8'),
+    ('dt', '<f8'),
+    ('dx', '<f8'),
+    ('x_min', '<f8'),
+    ('CFL', '<f8'),
+    ('u', '<f8'),
+    ('levels', '<i8'),
+    ('level_offset', '<i8'),
+    ('reserved', 'V104'),
+])
+
+LOD_LEVEL_DTYPE = np.dtype([
+    ('columns', '<i8'),
+    ('rows', '<i8'),
+    ('x_bin', '<i8'),
+    ('t_bin', '<i8'),
+    ('index_offset', '<i8'),
+])
+
+# Decimation factor of the pyramids built without a .lod file, as PyramidSink does
+LOD_FACTOR = 4
+
+
+class Result:
+    """
+    Memory-mapped view of a binary result file.
+
+    `f` is a (rows, N) numpy.memmap, so selecting a few time levels only
+    reads those rows from disk.
+    """
+
+    def __init__(self, file_path):
+        header = np.fromfile(file_path, dtype=HEADER_DTYPE, count=1)
+        if len(header) != 1 or header['magic'][0] != b'WESRES1':
+            raise ValueError(f"{file_path} is not a binary result file")
+        header = header[0]
+
+        self.path = file_path
+        self.scheme = header['scheme'].decode()
+        self.bondary = header['bondary'].decode()
+        self.N = int(header['N'])
+        self.rows = int(header['rows'])
+        self.dt = float(header['dt'])
+        self.dx = float(header['dx'])
+        self.x_min = float(header['x_min'])
+        self.CFL = float(header['CFL'])
+        self.u = float(header['u'])
+
+        dtype = '<f4' if header['value_size'] == 4 else '<f8'
+        self.f = np.memmap(file_path, dtype=dtype, mode='r', offset=int(header['data_offset']),
+                           shape=(self.rows, self.N))
+        table = np.memmap(file_path, dtype=TABLE_DTYPE, mode='r', offset=int(header['table_offset']),
+                          shape=(self.rows,))
+        self.level = np.array(table['level'])
+        self.t = np.array(table['t'])
+        self.x = self.x_min + np.arange(self.N) * self.dx
+
+    def row_at(self, t):
+        """Index of the stored row closest to time t."""
+        return int(np.abs(self.t - t).argmin())
+
+    def to_frame(self, rows=None):
+        """Long-format DataFrame with the x, t, f columns of the CSV export."""
+        rows = np.arange(self.rows) if rows is None else np.asarray(rows)
+        return pd.DataFrame({
+            'x': np.tile(self.x, len(rows)),
+            't': np.repeat(self.t[rows], self.N),
+            'f': np.asarray(self.f[rows], dtype='float64').ravel(),
+        })
+
+
+class _CompressedRows:
+    """Row access of a compressed file: `rows[i]`, `rows[[i, j]]` and `rows[a:b]` decode on demand."""
+
+    def __init__(self, result):
+        self.result = result
+
+    def __getitem__(self, key):
+        if np.isscalar(key):
+            return self.result.row(int(key))
+        indices = np.arange(self.result.rows)[key]
+        return np.array([self.result.row(int(i)) for i in indices]).reshape(len(indices), self.result.N)
+
+
+class CompressedResult(Result):
+    """
+    Compressed result file (.wez), decoded one block at a time.
+
+    `f[i]` decodes row i only: the file is memory-mapped and a row needs at
+    most `block_rows` rows of its block. The last decoded block position is
+    kept, so reading the rows in order decodes each row once. In the
+    error-bounded mode every value is within `tolerance` of the solver's.
+    """
+
+    def __init__(self, file_path):
+        header = np.fromfile(file_path, dtype=COMPRESSED_HEADER_DTYPE, count=1)
+        if len(header) != 1 or header['magic'][0] != b'WESZIP1':
+            raise ValueError(f"{file_path} is not a compressed result file")
+        header = header[0]
+
+        self.path = file_path
+        self.scheme = header['scheme'].decode()
+        self.bondary = header['bondary'].decode()
+        self.N = int(header['N'])
+        self.rows = int(header['rows'])
+        self.dt = float(header['dt'])
+        self.dx = float(header['dx'])
+        self.x_min = float(header['x_min'])
+        self.CFL = float(header['CFL'])
+        self.u = float(header['u'])
+        self.tolerance = float(header['tolerance'])
+        self.lossless = int(header['mode']) == 0
+        self.block_rows = int(header['block_rows'])
+
+        self._data = np.memmap(file_path, dtype=np.uint8, mode='r')
+        self._index = np.frombuffer(self._data, dtype='<i8', count=2 * int(header['blocks']),
+                                    offset=int(header['index_offset'])).reshape(-1, 2)
+        table = np.frombuffer(self._data, dtype=TABLE_DTYPE, count=self.rows, offset=int(header['table_offset']))
+        self.level = np.array(table['level'])
+        self.t = np.array(table['t'])
+        self.x = self.x_min + np.arange(self.N) * self.dx
+        self.f = _CompressedRows(self)
+        self._block = -1
+        self._next = 0
+
+    def row(self, i):
+        """Decoded float64 values of row i."""
+        block = i // self.block_rows
+        first = block * self.block_rows
+        if block != self._block or i < self._next - 1:
+            offset, size = (int(v) for v in self._index[block])
+            self._bytes = np.asarray(self._data[offset:offset + size])
+            self._cursor = 0
+            self._block = block
+            self._next = first
+        while self._next <= i:
+            self._decode(self._next == first)
+            self._next += 1
+        return self._values.copy()
+
+    def _decode(self, key):
+        """Decodes the next row of the block (the inverse of FieldCodec::encode)."""
+        n, data, pos = self.N, self._bytes, self._cursor
+        map_bytes = (n + 7) // 8
+        nonzero = np.unpackbits(data[pos:pos + map_bytes], bitorder='little')[:n].astype(bool)
+        pos += map_bytes
+        k = int(nonzero.sum())
+        packed = data[pos:pos + (k + 1) // 2]
+        pos += (k + 1) // 2
+        codes = np.empty(2 * len(packed), dtype=np.int64)
+        codes[0::2] = packed & 15
+        codes[1::2] = packed >> 4
+        codes = codes[:k]
+        lengths = np.where(codes == 8, 8, codes + 1)
+        starts = pos + np.cumsum(lengths) - lengths
+        pos += int(lengths.sum())
+        columns = np.arange(8)
+        present = columns < lengths[:, None]
+        padded = np.zeros((k, 8), dtype=np.uint8)
+        padded[present] = data[(starts[:, None] + columns)[present]]
+        residual = np.zeros(n, dtype=np.uint64)
+        residual[nonzero] = padded.view('<u8').ravel()
+        escape = np.zeros(n, dtype=bool)
+        escape[nonzero] = codes == 8
+        self._cursor = pos
+
+        if self.lossless:
+            symbol = np.bitwise_xor.accumulate(residual) if key else self._state ^ residual
+            self._values = symbol.view('<f8')
+        else:
+            delta = (residual >> np.uint64(1)).astype(np.int64) ^ -(residual & np.uint64(1)).astype(np.int64)
+            delta[escape] = 0
+            if key:
+                # Running sum along the row, restarted after every escape (whose symbol is 0)
+                total = np.cumsum(delta)
+                last = np.maximum.accumulate(np.where(escape, np.arange(n), -1))
+                symbol = total - np.where(last >= 0, total[np.maximum(last, 0)], 0)
+            else:
+                symbol = self._state.view('<i8') + delta
+            symbol[escape] = 0
+            self._values = symbol.astype('<f8') * (2 * self.tolerance)
+            self._values[escape] = residual[escape].view('<f8')
+            symbol = symbol.view('<u8')
+        self._state = np.array(symbol, dtype=np.uint64)
+
+
+def load_result(file_path):
+    """Open a binary (.wes) or compressed (.wez) result file."""
+    if file_path.endswith('.wez'):
+        return CompressedResult(file_path)
+    return Result(file_path)
+
+
+def read_frame(file_path):
+    """Load a result file (.wes, .wez or .csv) as an x, t, f DataFrame."""
+    if file_path.endswith(BINARY_EXTENSIONS):
+        return load_result(file_path).to_frame()
+    data = pd.read_csv(file_path)
+    data.columns = data.columns.str.strip()
+    return data
+
+
+def list_results(folder):
+    """
+    List the result files of a folder, one per run: the .wes file, else the
+    compressed .wez file, else the .csv export.
+    """
+    names = [f for f in os.listdir(folder) if f.endswith(RESULT_EXTENSIONS)]
+    stems = {ext: {os.path.splitext(f)[0] for f in names if f.endswith(ext)} for ext in BINARY_EXTENSIONS}
+
+    def preferred(name):
+        stem, ext = os.path.splitext(name)
+        if ext == '.wes':
+            return True
+        if ext == '.wez':
+            return stem not in stems['.wes']
+        return stem not in stems['.wes'] and stem not in stems['.wez']
+
+    return sorted(os.path.join(folder, f) for f in names if preferred(f))
+
+
+class LOD:
+    """
+    Level-of-detail view of a time range: (rows, columns) arrays `min`, `max`
+    and `mean` of f per cell, cell centres `x`, time ranges `t_first` and
+    `t_last` of each row and their midpoints `t`. At level 0 (full resolution)
+    the three arrays are the values themselves.
+    """
+
+    def __init__(self, level, x, t_first, t_last, f_min, f_max, f_mean):
+        self.level = level
+        self.x = x
+        self.t_first = t_first
+        self.t_last = t_last
+        self.t = 0.5 * (t_first + t_last)
+        self.min = f_min
+        self.max = f_max
+        self.mean = f_mean
+
+
+class Pyramid:
+    """Memory-mapped level-of-detail file (.lod) written next to a result file."""
+
+    def __init__(self, file_path):
+        header = np.fromfile(file_path, dtype=LOD_HEADER_DTYPE, count=1)
+        if len(header) != 1 or header['magic'][0] != b'WESLOD1':
+            raise ValueError(f"{file_path} is not a level-of-detail file")
+        header = header[0]
+
+        self.path = file_path
+        self.N = int(header['N'])
+        self.rows = int(header['rows'])
+        self.x_min = float(header['x_min'])
+        self.dx = float(header['dx'])
+        self._data = np.memmap(file_path, dtype=np.uint8, mode='r')
+        self.levels = np.frombuffer(self._data, dtype=LOD_LEVEL_DTYPE, count=int(header['levels']),
+                                    offset=int(header['level_offset']))
+        self._offsets = [np.frombuffer(self._data, dtype='<i8', count=int(level['rows']),
+                                       offset=int(level['index_offset'])) for level in self.levels]
+        self._times = [None] * len(self.levels)
+
+    def times(self, k):
+        """(rows, 2) array of the t_first, t_last of every record of level k (1 to len(levels))."""
+        if self._times[k - 1] is None:
+            offsets = self._offsets[k - 1]
+            raw = np.asarray(self._data[offsets[:, None] + np.arange(16)])
+            self._times[k - 1] = raw.copy().view('<f8').reshape(len(offsets), 2)
+        return self._times[k - 1]
+
+    def rows_in(self, k, t_min, t_max):
+        """First record and number of records of level k overlapping [t_min, t_max]."""
+        times = self.times(k)
+        first = int(np.searchsorted(times[:, 1], t_min, side='left'))
+        last = int(np.searchsorted(times[:, 0], t_max, side='right'))
+        return first, max(0, last - first)
+
+    def x(self, k):
+        """Cell centres of level k."""
+        x_bin = int(self.levels[k - 1]['x_bin'])
+        first = np.arange(int(self.levels[k - 1]['columns'])) * x_bin
+        last = np.minimum(self.N, first + x_bin) - 1
+        return self.x_min + 0.5 * (first + last) * self.dx
+
+    def read(self, k, t_min=-np.inf, t_max=np.inf):
+        """LOD of level k over [t_min, t_max]."""
+        first, count = self.rows_in(k, t_min, t_max)
+        columns = int(self.levels[k - 1]['columns'])
+        offsets = self._offsets[k - 1][first:first + count]
+        size = 16 + 12 * columns
+        raw = np.asarray(self._data[offsets[:, None] + np.arange(size)]).reshape(count, size)
+        times = raw[:, :16].copy().view('<f8').reshape(count, 2)
+        values = raw[:, 16:].copy().view('<f4').reshape(count, 3, columns).astype('float64')
+        return LOD(k, self.x(k), times[:, 0], times[:, 1], values[:, 0], values[:, 1], values[:, 2])
+
+
+def pyramid_path(file_path):
+    """Path of the .lod file of a result file."""
+    return os.path.splitext(file_path)[0] + '.lod'
+
+
+def _full_resolution(file_path, t_min, t_max):
+    """x, t and (rows, N) values of the full-resolution rows within [t_min, t_max]."""
+    if file_path.endswith(BINARY_EXTENSIONS):
+        result = load_result(file_path)
+        rows = np.flatnonzero((result.t >= t_min) & (result.t <= t_max))
+        values = np.asarray(result.f[rows], dtype='float64').reshape(len(rows), result.N)
+        return result.x, result.t[rows], values
+    data = read_frame(file_path)
+    data = data[(data['t'] >= t_min) & (data['t'] <= t_max)].sort_values(['t', 'x'], kind='stable')
+    t = data['t'].unique()
+    x = data['x'].unique()
+    return np.sort(x), t, data['f'].to_numpy(dtype='float64').reshape(len(t), -1)
+
+
+def _decimate(values, x, t, x_bin, t_bin):
+    """Min, max and mean over cells of x_bin points by t_bin rows, with the x and t of each cell."""
+    rows, columns = values.shape
+    padded_rows = -(-rows // t_bin) * t_bin
+    padded_columns = -(-columns // x_bin) * x_bin
+    cells = np.full((padded_rows, padded_columns), np.nan)
+    cells[:rows, :columns] = values
+    cells = cells.reshape(padded_rows // t_bin, t_bin, padded_columns // x_bin, x_bin)
+    f_min = np.nanmin(cells, axis=(1, 3))
+    f_max = np.nanmax(cells, axis=(1, 3))
+    f_mean = np.nanmean(cells, axis=(1, 3))
+    starts = np.arange(0, columns, x_bin)
+    centres = 0.5 * (x[starts] + x[np.minimum(columns, starts + x_bin) - 1])
+    t_first = t[::t_bin]
+    t_last = t[np.minimum(rows, np.arange(1, len(t_first) + 1) * t_bin) - 1]
+    return centres, t_first, t_last, f_min, f_max, f_mean
+
+
+def query(file_path, t_min=None, t_max=None, max_rows=None, max_columns=None, level=None):
+    """
+    Min/max/mean of a result file over [t_min, t_max], at the finest level
+    with at most max_rows rows and max_columns columns (or at `level`).
+
+    With a .lod file next to the result, only the chosen level is read;
+    level 0 reads the full-resolution rows of the range. Without it the
+    rows of the range are read and decimated the same way.
+    """
+    t_min = -np.inf if t_min is None else t_min
+    t_max = np.inf if t_max is None else t_max
+    max_rows = np.inf if max_rows is None else max_rows
+    max_columns = np.inf if max_columns is None else max_columns
+
+    lod_path = pyramid_path(file_path)
+    if os.path.exists(lod_path):
+        pyramid = Pyramid(lod_path)
+        if level is None:
+            level = len(pyramid.levels)
+            for k in range(len(pyramid.levels), -1, -1):
+                if k == 0:
+                    # Full-resolution rows of the range, bounded by the records of level 1 that cover it
+                    count = pyramid.rows_in(1, t_min, t_max)[1] * int(pyramid.levels[0]['t_bin']) if len(pyramid.levels) else 0
+                    columns = pyramid.N
+                else:
+                    count = pyramid.rows_in(k, t_min, t_max)[1]
+                    columns = int(pyramid.levels[k - 1]['columns'])
+                if count <= max_rows and columns <= max_columns:
+                    level = k
+                else:
+                    break
+        if level > 0:
+            return pyramid.read(level, t_min, t_max)
+
+    x, t, values = _full_resolution(file_path, t_min, t_max)
+    if level is None:
+        level = 0
+        while (-(-len(t) // LOD_FACTOR ** level) > max_rows or -(-len(x) // LOD_FACTOR ** level) > max_columns) \
+                and LOD_FACTOR ** level < max(len(t), len(x), 1):
+            level += 1
+    if level == 0:
+        return LOD(0, x, t, t, values, values, values)
+    return LOD(level, *_decimate(values, x, t, LOD_FACTOR ** level, LOD_FACTOR ** level))
+
+
+def read_levels(file_path, times):
+    """x and the full-resolution rows closest to each of `times`, without reading the other rows of binary files."""
+    if file_path.endswith(BINARY_EXTENSIONS):
+        result = load_result(file_path)
+        rows = [result.row_at(t) for t in times]
+        return result.x, result.t[rows], np.asarray(result.f[rows], dtype='float64').reshape(len(rows), result.N)
+    x, t, values = _full_resolution(file_path, -np.inf, np.inf)
+    rows = [int(np.abs(t - time).argmin()) for time in times]
+    return x, t[rows], values[rows]
+
+
+def time_range(file_path):
+    """First and last stored times of a result file."""
+    if file_path.endswith(BINARY_EXTENSIONS):
+        t = load_result(file_path).t
+    else:
+        t = read_frame(file_path)['t'].to_numpy()
+    return float(t.min()), float(t.max())
+
+
+def value_range(file_path):
+    """Smallest and largest f of a result file, from the coarsest level of its pyramid when there is one."""
+    lod = query(file_path, max_rows=1, max_columns=1)
+    return float(np.nanmin(lod.min)), float(np.nanmax(lod.max))
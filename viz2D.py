@@ -1,39 +1,36 @@
-import pandas as pd
 import matplotlib.pyplot as plt
 import os
+from resultio import query, read_levels, list_results
 import numpy as np
 from matplotlib.cm import ScalarMappable
 from matplotlib.colors import Normalize
 
-def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
+def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2, max_curves=200, max_points=2000):
     """
     Generate a 2D plot of x vs f(x, t) for different time values (t) from a CSV file,
     ensuring the initial condition (t=0) is prominently displayed and a gradient is added to other curves.
     """
-    # Load the CSV file
-    data = pd.read_csv(file_path)
-
-    # Strip any leading or trailing spaces from column names
-    data.columns = data.columns.str.strip()
+    # Load at most max_curves time levels of at most max_points x values (read from the
+    # .lod pyramid when the run has one, full resolution for small runs)
+    lod = query(file_path, max_rows=max_curves, max_columns=max_points)
 
     # Normalize time values for colormap scaling
-    t_values = data['t'].unique()
-    min_t, max_t = t_values.min(), t_values.max()
+    t_values = lod.t
+    min_t, max_t = lod.t_first.min(), lod.t_last.max()
     norm = Normalize(vmin=min_t, vmax=max_t)
     cmap = plt.get_cmap('plasma')  # Use a high-contrast colormap
 
     # Set up the figure
     fig, ax = plt.subplots(figsize=(8, 4))  # Create figure and axes
 
-    # Plot the initial condition (t = min_t) prominently
-    subset_t0 = data[data['t'] == min_t]
-    ax.plot(subset_t0['x'], subset_t0['f'], color='red', linewidth=3)  # Thicker line for visibility
+    # Plot the initial condition (t = min_t) prominently, always at full resolution
+    x0, _, f0 = read_levels(file_path, [min_t])
+    ax.plot(x0, f0[0], color='red', linewidth=3)  # Thicker line for visibility
 
     # Plot the rest with polychrome gradient and thicker lines
-    for t in t_values[1:]:
-        subset = data[data['t'] == t]
-        color = cmap(norm(t))  # Get color from the colormap
-        ax.plot(subset['x'], subset['f'], color=color, linestyle='--', linewidth=1.5)  # Thicker dashed lines
+    for i in range(1 if lod.level == 0 else 0, len(t_values)):
+        color = cmap(norm(t_values[i]))  # Get color from the colormap
+        ax.plot(lod.x, lod.mean[i], color=color, linestyle='--', linewidth=1.5)  # Thicker dashed lines
 
     # Add a colorbar to indicate the mapping of time values to colors
     sm = ScalarMappable(cmap=cmap, norm=norm)
@@ -47,7 +44,7 @@ def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
     ax.grid(True)
 
     # Adjust y-axis limits with a margin
-    f_min, f_max = data['f'].min(), data['f'].max()
+    f_min, f_max = lod.min.min(), lod.max.max()
     margin = (f_max - f_min) * margin_factor
     ax.set_ylim(f_min - margin, f_max + margin)
 
@@ -62,7 +59,7 @@ def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
         os.makedirs(output_folder)
 
     # Save the plot in the 'Images' folder
-    output_file = os.path.join(output_folder, os.path.basename(file_path).replace('.csv', '_2D_plot.png'))
+    output_file = os.path.join(output_folder, os.path.splitext(os.path.basename(file_path))[0] + '_2D_plot.png')
     fig.tight_layout()
     fig.savefig(output_file)  # Save the plot
     print(f"Plot saved: {output_file}")
@@ -83,10 +80,10 @@ def main():
         print(f"The folder '{input_folder}' does not exist.")
         return
 
-    csv_files = [os.path.join(input_folder, f) for f in os.listdir(input_folder) if f.endswith('.csv')]
+    csv_files = list_results(input_folder)
 
     if not csv_files:
-        print(f"No CSV files found in the folder '{input_folder}'.")
+        print(f"No result files found in the folder '{input_folder}'.")
         return
 
     for file in csv_files:
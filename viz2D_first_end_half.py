@@ -1,6 +1,6 @@
-import pandas as pd
 import matplotlib.pyplot as plt
 import os
+from resultio import read_levels, time_range, value_range, list_results
 
 def parse_title(file_name):
     """
@@ -49,19 +49,12 @@ def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
     Generate a 2D plot of x vs f(x, t) for the first (t=min_t), last (t=max_t),
     and midpoint (t closest to max_t/2) time values.
     """
-    # Load the CSV file
-    data = pd.read_csv(file_path)
-
-    # Strip any leading or trailing spaces from column names
-    data.columns = data.columns.str.strip()
-
-    # Extract the unique time values
-    t_values = data['t'].unique()
-    min_t, max_t = t_values.min(), t_values.max()
+    # Read only the first, last and midpoint time levels of the result file (.wes, .wez or .csv)
+    min_t, max_t = time_range(file_path)
     mid_t = max_t / 2
 
-    # Find the time value closest to t = max_t / 2
-    closest_mid_t = t_values[(abs(t_values - mid_t)).argmin()]
+    # The stored time levels closest to t = min_t, max_t / 2 and max_t
+    x, t, f = read_levels(file_path, [min_t, mid_t, max_t])
 
     # Parse the title from the file name
     title = parse_title(os.path.basename(file_path))
@@ -72,16 +65,13 @@ def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
     plt.figure(figsize=(width, height))
 
     # Plot the first time point (t = min_t)
-    subset_t0 = data[data['t'] == min_t]
-    plt.plot(subset_t0['x'], subset_t0['f'], color='#B74F6F', linewidth=2)
+    plt.plot(x, f[0], color='#B74F6F', linewidth=2)
 
     # Plot the midpoint time (t closest to max_t / 2)
-    subset_t_mid = data[data['t'] == closest_mid_t]
-    plt.plot(subset_t_mid['x'], subset_t_mid['f'], color='#FB8B24', linewidth=2, linestyle='-.')
+    plt.plot(x, f[1], color='#FB8B24', linewidth=2, linestyle='-.')
 
     # Plot the last time point (t = max_t)
-    subset_t_last = data[data['t'] == max_t]
-    plt.plot(subset_t_last['x'], subset_t_last['f'], color='#3185FC', linewidth=2, linestyle='--')
+    plt.plot(x, f[2], color='#3185FC', linewidth=2, linestyle='--')
 
     # Customize the plot
     plt.xlabel('x')
@@ -90,7 +80,8 @@ def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
     plt.grid(True)
 
     # Adjust y-axis limits with a margin
-    f_min, f_max = data['f'].min(), data['f'].max()
+    # Range of f over every time level, from the .lod pyramid when the run has one
+    f_min, f_max = value_range(file_path)
     margin = (f_max - f_min) * margin_factor
     plt.ylim(f_min - margin, f_max + margin)
 
@@ -105,7 +96,7 @@ def plot_csv(file_path, output_folder, min_height=0.2, margin_factor=0.2):
         os.makedirs(output_folder)
 
     # Save the plot in the 'Images' folder
-    output_file = os.path.join(output_folder, os.path.basename(file_path).replace('.csv', '_2D_plot.png'))
+    output_file = os.path.join(output_folder, os.path.splitext(os.path.basename(file_path))[0] + '_2D_plot.png')
     plt.tight_layout()
     plt.savefig(output_file)  # Save the plot
     print(f"Plot saved: {output_file}")
@@ -126,10 +117,10 @@ def main():
         print(f"The folder '{input_folder}' does not exist.")
         return
 
-    csv_files = [os.path.join(input_folder, f) for f in os.listdir(input_folder) if f.endswith('.csv')]
+    csv_files = list_results(input_folder)
 
     if not csv_files:
-        print(f"No CSV files found in the folder '{input_folder}'.")
+        print(f"No result files found in the folder '{input_folder}'.")
         return
 
     for file in csv_files:
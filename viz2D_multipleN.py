@@ -1,6 +1,8 @@
-import pandas as pd
 import matplotlib.pyplot as plt
 import os
+import numpy as np
+import pandas as pd
+from resultio import read_levels, time_range
 
 def plot_t0_tn(file_paths, dataframes, output_path):
     """
@@ -51,7 +53,9 @@ def main():
     # Load and preprocess data
     dataframes = []
     for file_path in file_paths:
-        df = pd.read_csv(file_path, skiprows=1, names=['x', 't', 'f'])  # Skip header row and assign correct column names
+        # Only the first and last time levels (.wes, .wez or .csv), as x, t, f columns
+        x, t, f = read_levels(file_path, time_range(file_path))
+        df = pd.DataFrame({'x': np.tile(x, len(t)), 't': np.repeat(t, len(x)), 'f': f.ravel()})
         df = df.astype({'x': 'float64', 't': 'float64', 'f': 'float64'})  # Ensure numeric data
         dataframes.append(df)
 
@@ -1,22 +1,21 @@
-import pandas as pd
 import matplotlib.pyplot as plt
 from mpl_toolkits.mplot3d import Axes3D
 import os
+import numpy as np
+from resultio import query, list_results
 
-def plot_3d_csv(file_path, output_folder):
+def plot_3d_csv(file_path, output_folder, max_rows=250, max_columns=1000):
     """
     Reads a CSV file and generates a 3D visualization, saving the plot in the specified output folder.
     """
-    # Load the data
-    df = pd.read_csv(file_path)
-    
-    # Remove spaces from column names
-    df.columns = df.columns.str.strip()
+    # Load at most max_rows x max_columns cells (from the .lod pyramid when the run has one,
+    # full resolution for small runs): a screen cannot show more points
+    lod = query(file_path, max_rows=max_rows, max_columns=max_columns)
     
     # Extract columns
-    x = df['x']
-    t = df['t']
-    f = df['f']
+    x = np.tile(lod.x, len(lod.t))
+    t = np.repeat(lod.t, len(lod.x))
+    f = lod.mean.ravel()
     
     # Create a color palette based on the f values
     norm = plt.Normalize(vmin=f.min(), vmax=f.max())  # Normalize based on f range
@@ -40,7 +39,7 @@ def plot_3d_csv(file_path, output_folder):
     ax.set_title(f'3D Visualization - {os.path.basename(file_path)}')
     
     # Save the plot in the specified output folder
-    output_file = os.path.join(output_folder, os.path.basename(file_path).replace('.csv', '_3D_plot.png'))
+    output_file = os.path.join(output_folder, os.path.splitext(os.path.basename(file_path))[0] + '_3D_plot.png')
     plt.savefig(output_file)
     print(f"Plot saved: {output_file}")
     
@@ -64,10 +63,10 @@ def main():
         return
     
     # Get all CSV files in the input folder
-    csv_files = [os.path.join(input_folder, f) for f in os.listdir(input_folder) if f.endswith('.csv')]
+    csv_files = list_results(input_folder)
     
     if not csv_files:
-        print(f"No CSV files found in the folder '{input_folder}'.")
+        print(f"No result files found in the folder '{input_folder}'.")
         return
     
     # Process each CSV file